@@ -69,8 +69,10 @@ void load_settings() {
 	var_loop_mode = std::min(2, std::max(0, load_int("loop_mode", 0)));
 	var_video_quality = std::min(480, std::max(0, load_int("video_quality", var_is_new3ds ? 360 : 144)));
 	var_forward_buffer_ratio = std::max(0.1, std::min(1.0, load_double("forward_buffer_ratio", 0.8)));
+	var_prefetch_window = std::max(1, std::min(4, load_int("prefetch_window", 3)));
 	var_history_enabled = load_int("history_enabled", 1);
 	var_video_show_debug_info = load_int("video_show_debug_info", 0);
+	var_video_telemetry_export = load_int("video_telemetry_export", 0);
 	var_player_response = load_int("player_response", 0);
 	var_video_linear_filter = load_int("linear_filter", 1);
 	var_dpad_scroll_speed0 = std::max(1.0, std::min(12.0, load_double("dpad_scroll_speed0", 6.0)));
@@ -117,8 +119,10 @@ void save_settings() {
 	add_int("loop_mode", var_loop_mode);
 	add_int("video_quality", var_video_quality);
 	add_double("forward_buffer_ratio", var_forward_buffer_ratio);
+	add_int("prefetch_window", var_prefetch_window);
 	add_int("history_enabled", var_history_enabled);
 	add_int("video_show_debug_info", var_video_show_debug_info);
+	add_int("video_telemetry_export", var_video_telemetry_export);
 	add_int("player_response", var_player_response);
 	add_int("linear_filter", var_video_linear_filter);
 	add_double("dpad_scroll_speed0", var_dpad_scroll_speed0);
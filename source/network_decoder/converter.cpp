@@ -324,8 +324,6 @@ Result_with_string Util_converter_bgr888_to_yuv420p(u8 *bgr888, u8 **yuv420p, in
 
 Result_with_string Util_converter_y2r_yuv420p_to_bgr565(u8 *yuv420p, u8 **bgr565, int width, int height,
                                                         bool texture_format) {
-	bool finished = false;
-	Y2RU_ConversionParams y2r_parameters;
 	Result_with_string result;
 
 	*bgr565 = (u8 *)malloc(width * height * 2);
@@ -335,6 +333,17 @@ Result_with_string Util_converter_y2r_yuv420p_to_bgr565(u8 *yuv420p, u8 **bgr565
 		return result;
 	}
 
+	return Util_converter_y2r_yuv420p_to_bgr565(yuv420p, yuv420p + (width * height),
+	                                            yuv420p + ((width * height) + (width * height / 4)), width, width / 2,
+	                                            *bgr565, width, height, texture_format);
+}
+
+Result_with_string Util_converter_y2r_yuv420p_to_bgr565(u8 *y, u8 *u, u8 *v, int y_stride, int uv_stride, u8 *bgr565,
+                                                        int width, int height, bool texture_format) {
+	bool finished = false;
+	Y2RU_ConversionParams y2r_parameters;
+	Result_with_string result;
+
 	y2r_parameters.input_format = INPUT_YUV420_INDIV_8;
 	y2r_parameters.output_format = OUTPUT_RGB_16_565;
 	y2r_parameters.rotation = ROTATION_NONE;
@@ -354,26 +363,26 @@ Result_with_string Util_converter_y2r_yuv420p_to_bgr565(u8 *yuv420p, u8 **bgr565
 		return result;
 	}
 
-	result.code = Y2RU_SetSendingY(yuv420p, width * height, width, 0);
+	// the padding at the end of each line is skipped by the transfer gap
+	result.code = Y2RU_SetSendingY(y, width * height, width, y_stride - width);
 	if (result.code != 0) {
 		result.string = "[Error] Y2RU_SetSendingY() failed. ";
 		return result;
 	}
 
-	result.code = Y2RU_SetSendingU(yuv420p + (width * height), width * height / 4, width / 2, 0);
+	result.code = Y2RU_SetSendingU(u, width * height / 4, width / 2, uv_stride - width / 2);
 	if (result.code != 0) {
 		result.string = "[Error] Y2RU_SetSendingU() failed. ";
 		return result;
 	}
 
-	result.code =
-	    Y2RU_SetSendingV(yuv420p + ((width * height) + (width * height / 4)), width * height / 4, width / 2, 0);
+	result.code = Y2RU_SetSendingV(v, width * height / 4, width / 2, uv_stride - width / 2);
 	if (result.code != 0) {
 		result.string = "[Error] Y2RU_SetSendingV() failed. ";
 		return result;
 	}
 
-	result.code = Y2RU_SetReceiving(*bgr565, width * height * 2, width * 2 * 4, 0);
+	result.code = Y2RU_SetReceiving(bgr565, width * height * 2, width * 2 * 4, 0);
 	if (result.code != 0) {
 		result.string = "[Error] Y2RU_SetReceiving() failed. ";
 		return result;
@@ -21,3 +21,8 @@ Result_with_string Util_converter_bgr888_to_yuv420p(u8 *bgr888, u8 **yuv420p, in
 
 Result_with_string Util_converter_y2r_yuv420p_to_bgr565(u8 *yuv420p, u8 **bgr565, int width, int height,
                                                         bool texture_format);
+
+// converts the planes of a yuv420p image, each line of which may be followed by padding (`*_stride` is the distance
+// between the lines in bytes), into `bgr565` of width * height * 2 bytes without allocating anything
+Result_with_string Util_converter_y2r_yuv420p_to_bgr565(u8 *y, u8 *u, u8 *v, int y_stride, int uv_stride, u8 *bgr565,
+                                                        int width, int height, bool texture_format);
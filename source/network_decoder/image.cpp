@@ -3,28 +3,74 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image/stb_image.h"
 
-// returns in BGR565 format, should be freed
-u8 *Image_decode(u8 *input, size_t input_len, int *width, int *height) {
+static inline u16 rgb888_to_bgr565(const u8 *pixel) {
+	return ((pixel[0] & 0b11111000) << 8) | ((pixel[1] & 0b11111100) << 3) | (pixel[2] >> 3);
+}
+// the offset (in pixels) of (x, y) in a texture of width `tex_width` : the texture consists of 8x8 tiles, and the
+// pixels in a tile are in the Z-order
+static inline u32 get_tiled_offset(int x, int y, int tex_width) {
+	u32 z_order = (x & 1) | (y & 1) << 1 | (x & 2) << 1 | (y & 2) << 2 | (x & 4) << 2 | (y & 4) << 3;
+	return (y >> 3) * tex_width * 8 + (x >> 3) * 64 + z_order;
+}
+
+Result_with_string Image_decode_to_texture(u8 *input, size_t input_len, Image_data *texture, int *width, int *height,
+                                           const std::function<void(int w, int h, int &top, int &height)> &crop,
+                                           const std::function<u16(u16 pixel, int x, int y)> &pixel_filter) {
+	Result_with_string result;
+	int image_w = 0;
+	int image_h = 0;
 	int image_ch = 0;
-	u8 *rgb_image = stbi_load_from_memory(input, input_len, width, height, &image_ch, STBI_rgb);
+	u8 *rgb_image = stbi_load_from_memory(input, input_len, &image_w, &image_h, &image_ch, STBI_rgb);
 	if (!rgb_image) {
 		logger.error("image-dec", "stbi load failed : " + std::string(stbi_failure_reason()));
-		return NULL;
+		result.code = DEF_ERR_STB_IMG_RETURNED_NOT_SUCCESS;
+		result.string = DEF_ERR_STB_IMG_RETURNED_NOT_SUCCESS_STR;
+		result.error_description = stbi_failure_reason();
+		return result;
 	}
-	u8 *bgr_image = (u8 *)malloc(*width * *height * 2);
-	if (!bgr_image) {
-		stbi_image_free(rgb_image);
-		return NULL;
+	int top = 0;
+	int w = image_w;
+	int h = image_h;
+	if (crop) {
+		crop(image_w, image_h, top, h);
+		h = std::max(0, std::min(h, image_h - top));
+	}
+
+	int texture_w = 1;
+	while (texture_w < w) {
+		texture_w <<= 1;
 	}
-	int in_size = *width * *height * 3;
-	u16 *out_head = (u16 *)bgr_image;
-	for (int i = 0; i < in_size; i += 3) {
-		u16 r = rgb_image[i + 0];
-		u16 g = rgb_image[i + 1];
-		u16 b = rgb_image[i + 2];
-		*out_head++ = ((r & 0b11111000) << 8) | ((g & 0b11111100) << 3) | (b >> 3);
+	int texture_h = 1;
+	while (texture_h < h) {
+		texture_h <<= 1;
+	}
+	result = Draw_c2d_image_init(texture, texture_w, texture_h, GPU_RGB565);
+	if (result.code != 0) {
+		stbi_image_free(rgb_image);
+		return result;
 	}
 
+	// converted, filtered and swizzled in a single pass without any intermediate RGB565 buffer
+	u16 *texture_data = (u16 *)texture->c2d.tex->data;
+	for (int y = 0; y < h; y++) {
+		// Draw_set_texture_data() fills the first row of the texture with the second row of the image
+		// this is kept as is so that the result stays the same as before
+		int src_y = (y == 0 && h > 1) ? 1 : y;
+		const u8 *src = rgb_image + (size_t)(top + src_y) * w * 3;
+		for (int x = 0; x < w; x++) {
+			u16 pixel = rgb888_to_bgr565(src + x * 3);
+			if (pixel_filter) {
+				pixel = pixel_filter(pixel, x, src_y);
+			}
+			texture_data[get_tiled_offset(x, y, texture_w)] = pixel;
+		}
+	}
 	stbi_image_free(rgb_image);
-	return bgr_image;
+
+	Draw_c2d_image_set_subtex(texture, w, h);
+	C3D_TexFlush(texture->c2d.tex);
+
+	*width = w;
+	*height = h;
+	return result;
 }
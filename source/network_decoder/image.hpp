@@ -1,3 +1,11 @@
 #pragma once
+#include <functional>
 
-u8 *Image_decode(u8 *input, size_t input_len, int *width, int *height);
+// decodes the image and writes it straight into a new power-of-two RGB565 texture in the tiled layout of the GPU
+// (`texture` should be freed with Draw_c2d_image_free())
+// `crop`, if given, is called with the size of the decoded image and chooses the rows [top, top + height) to be used
+// `pixel_filter`, if given, is applied to each pixel (in BGR565) with its position in the cropped image
+// `width` and `height` are set to the size of the cropped image
+Result_with_string Image_decode_to_texture(u8 *input, size_t input_len, Image_data *texture, int *width, int *height,
+                                           const std::function<void(int w, int h, int &top, int &height)> &crop,
+                                           const std::function<u16(u16 pixel, int x, int y)> &pixel_filter);
@@ -26,6 +26,9 @@ void NetworkDecoderFFmpegIOData::deinit(bool deinit_stream) {
 		deinit_(type, deinit_stream);
 	}
 }
+// the downloader signals the stream as soon as a block lands, this only bounds the latency of noticing
+// interrupts and quit requests
+#define NETWORK_WAIT_TIMEOUT_NS (100 * 1000 * 1000)
 static int read_network_stream(void *opaque, u8 *buf, int buf_size_) { // size or AVERROR_EOF
 	NetworkDecoder *decoder = ((std::pair<NetworkDecoder *, NetworkStream *> *)opaque)->first;
 	NetworkStream *stream = ((std::pair<NetworkDecoder *, NetworkStream *> *)opaque)->second;
@@ -34,6 +37,7 @@ static int read_network_stream(void *opaque, u8 *buf, int buf_size_) { // size o
 	// Util_log_save("dec", "read " + std::to_string(stream->read_head) + " " + std::to_string(buf_size_) + " " +
 	// std::to_string(stream->len));
 	bool cpu_limited = false;
+	bool waited = false;
 	while (!stream->ready ||
 	       !stream->is_data_available(stream->read_head, std::min<u64>(buf_size, stream->len - stream->read_head))) {
 		if (stream->ready && stream->read_head >= stream->len) {
@@ -47,11 +51,12 @@ static int read_network_stream(void *opaque, u8 *buf, int buf_size_) { // size o
 			goto fail;
 		}
 		stream->network_waiting_status = "Reading stream";
+		waited = true;
 		if (!cpu_limited) {
 			cpu_limited = true;
 			add_cpu_limit(ADDITIONAL_CPU_LIMIT);
 		}
-		usleep(20000);
+		stream->wait_for_update(NETWORK_WAIT_TIMEOUT_NS);
 		if (stream->error || stream->quit_request) {
 			// show the error message only once per stream
 			if (!stream->read_dead_tried) {
@@ -68,13 +73,18 @@ static int read_network_stream(void *opaque, u8 *buf, int buf_size_) { // size o
 	stream->network_waiting_status = NULL;
 
 	{
-		auto tmp = stream->get_data(stream->read_head, std::min<u64>(buf_size, stream->len - stream->read_head));
-		size_t read_size = tmp.size();
-		stream->read_head += read_size;
-		memcpy(buf, &tmp[0], read_size);
+		size_t read_size = std::min<u64>(buf_size, stream->len - stream->read_head);
 		if (!read_size) {
 			return AVERROR_EOF;
 		}
+		if (waited) {
+			stream->cache_stats.miss_num++;
+		} else {
+			stream->cache_stats.hit_num++;
+		}
+		// copied straight from the block arena into the AVIO buffer
+		stream->read_data(stream->read_head, read_size, buf);
+		stream->set_read_head(stream->read_head + read_size);
 		return read_size;
 	}
 
@@ -94,7 +104,7 @@ static int64_t seek_network_stream(void *opaque, s64 offset, int whence) { // si
 
 	while (!stream->ready) {
 		stream->network_waiting_status = "Reading stream (init, seek)";
-		usleep(20000);
+		stream->wait_for_update(NETWORK_WAIT_TIMEOUT_NS);
 		if (stream->error || stream->quit_request) {
 			stream->network_waiting_status = NULL;
 			return -1;
@@ -122,7 +132,7 @@ static int64_t seek_network_stream(void *opaque, s64 offset, int whence) { // si
 		return -1;
 	}
 
-	stream->read_head = new_pos;
+	stream->set_read_head(new_pos);
 
 	return stream->read_head;
 }
@@ -136,11 +146,33 @@ void ffmpeg_log_callback(void *, int level, const char *fmt, va_list vargs) {
 }
 
 #define NETWORK_BUFFER_SIZE 0x10000
-Result_with_string NetworkDecoderFFmpegIOData::init_(int type, NetworkDecoder *parent_decoder) {
+// whether the streams found only from the container header are not enough to start decoding
+static bool is_probe_needed(AVFormatContext *format_context,
+                            const std::vector<std::pair<AVMediaType, AVCodecID>> &probed_streams) {
+	if (format_context->nb_streams != probed_streams.size()) {
+		return true;
+	}
+	for (size_t i = 0; i < format_context->nb_streams; i++) {
+		AVCodecParameters *codecpar = format_context->streams[i]->codecpar;
+		if (codecpar->codec_type != probed_streams[i].first || codecpar->codec_id != probed_streams[i].second) {
+			return true;
+		}
+		if (codecpar->codec_type == AVMEDIA_TYPE_VIDEO && (codecpar->width <= 0 || codecpar->height <= 0)) {
+			return true;
+		}
+		if (codecpar->codec_type == AVMEDIA_TYPE_AUDIO &&
+		    (codecpar->sample_rate <= 0 || codecpar->ch_layout.nb_channels <= 0)) {
+			return true;
+		}
+	}
+	return false;
+}
+Result_with_string NetworkDecoderFFmpegIOData::init_(int type, NetworkDecoder *parent_decoder,
+                                                     const ProbeInfo *probed) {
 	Result_with_string result;
 	int ffmpeg_result;
 
-	network_stream[type]->read_head = 0;
+	network_stream[type]->set_read_head(0);
 
 	opaque[type] = new std::pair<NetworkDecoder *, NetworkStream *>(parent_decoder, network_stream[type]);
 	unsigned char *buffer = (unsigned char *)av_malloc(NETWORK_BUFFER_SIZE);
@@ -166,15 +198,22 @@ Result_with_string NetworkDecoderFFmpegIOData::init_(int type, NetworkDecoder *p
 		return result;
 	}
 	format_context[type]->pb = io_context[type];
-	ffmpeg_result = avformat_open_input(&format_context[type], "yay", NULL, NULL);
+	// the blocks containing the container header are likely to be read again on the next reinit, keep them cached
+	network_stream[type]->protect_reads = true;
+	// the input format of the probed stream is reused so that the format is not detected again
+	ffmpeg_result = avformat_open_input(&format_context[type], "yay", probed ? probed->input_format[type] : NULL, NULL);
+	network_stream[type]->protect_reads = false;
 	if (ffmpeg_result != 0) {
 		result.error_description = "avformat_open_input() failed " + std::to_string(ffmpeg_result);
 		goto fail;
 	}
-	ffmpeg_result = avformat_find_stream_info(format_context[type], NULL);
-	if (!format_context[type]) {
-		result.error_description = "avformat_find_stream_info() failed " + std::to_string(ffmpeg_result);
-		goto fail;
+	if (!probed || is_probe_needed(format_context[type], probed->streams[type])) {
+		ffmpeg_result = avformat_find_stream_info(format_context[type], NULL);
+		if (!format_context[type]) {
+			result.error_description = "avformat_find_stream_info() failed " + std::to_string(ffmpeg_result);
+			goto fail;
+		}
+		probe_skipped = false;
 	}
 	if (video_audio_separate) {
 		if (format_context[type]->nb_streams != 1) {
@@ -198,6 +237,7 @@ Result_with_string NetworkDecoderFFmpegIOData::init_(int type, NetworkDecoder *p
 			}
 		}
 	}
+	import_keyframe_index(type);
 	return result;
 
 fail:
@@ -213,20 +253,24 @@ fail:
 		}                                                                                                              \
 	} while (0)
 Result_with_string NetworkDecoderFFmpegIOData::init(NetworkStream *video_stream, NetworkStream *audio_stream,
-                                                    NetworkDecoder *parent_decoder) {
+                                                    NetworkDecoder *parent_decoder, const ProbeInfo *probed) {
 	Result_with_string result;
 
 	video_audio_separate = video_stream != audio_stream;
 	network_stream[VIDEO] = video_stream;
 	network_stream[AUDIO] = audio_stream;
 	this->parent_decoder = parent_decoder;
+	if (probed && (!probed->valid || probed->video_audio_separate != video_audio_separate)) {
+		probed = NULL;
+	}
+	probe_skipped = probed != NULL; // reset by init_() if probing turns out to be needed
 
 	// init io
 	if (video_audio_separate) {
-		RETURN_WITH_PREFIX_ON_ERROR(init_(VIDEO, parent_decoder), "[v] ");
-		RETURN_WITH_PREFIX_ON_ERROR(init_(AUDIO, parent_decoder), "[a] ");
+		RETURN_WITH_PREFIX_ON_ERROR(init_(VIDEO, parent_decoder, probed), "[v] ");
+		RETURN_WITH_PREFIX_ON_ERROR(init_(AUDIO, parent_decoder, probed), "[a] ");
 	} else {
-		RETURN_WITH_PREFIX_ON_ERROR(init_(VIDEO, parent_decoder), "[v+a] ");
+		RETURN_WITH_PREFIX_ON_ERROR(init_(VIDEO, parent_decoder, probed), "[v+a] ");
 	}
 
 	if (stream_index[VIDEO] == -1) {
@@ -240,8 +284,25 @@ Result_with_string NetworkDecoderFFmpegIOData::init(NetworkStream *video_stream,
 
 	return result;
 }
-Result_with_string NetworkDecoderFFmpegIOData::init(NetworkStream *both_stream, NetworkDecoder *parent_decoder) {
-	return init(both_stream, both_stream, parent_decoder);
+Result_with_string NetworkDecoderFFmpegIOData::init(NetworkStream *both_stream, NetworkDecoder *parent_decoder,
+                                                    const ProbeInfo *probed) {
+	return init(both_stream, both_stream, parent_decoder, probed);
+}
+NetworkDecoderFFmpegIOData::ProbeInfo NetworkDecoderFFmpegIOData::get_probe_info() {
+	ProbeInfo res;
+	res.video_audio_separate = video_audio_separate;
+	for (int type = 0; type < (video_audio_separate ? 2 : 1); type++) {
+		if (!format_context[type]) {
+			return ProbeInfo();
+		}
+		res.input_format[type] = format_context[type]->iformat;
+		for (size_t i = 0; i < format_context[type]->nb_streams; i++) {
+			AVCodecParameters *codecpar = format_context[type]->streams[i]->codecpar;
+			res.streams[type].push_back({codecpar->codec_type, codecpar->codec_id});
+		}
+	}
+	res.valid = true;
+	return res;
 }
 Result_with_string NetworkDecoderFFmpegIOData::reinit() {
 	deinit(false);
@@ -254,9 +315,9 @@ Result_with_string NetworkDecoderFFmpegIOData::reinit_stream(int type, int64_t s
 
 	logger.info("debug", "avformat reinit #" + std::to_string(type) + "...");
 	deinit_(type, false);
-	RETURN_WITH_PREFIX_ON_ERROR(init_(type, parent_decoder), video_audio_separate ? "[v+a]"
-	                                                         : type == VIDEO      ? "[v]"
-	                                                                              : "[a]");
+	RETURN_WITH_PREFIX_ON_ERROR(init_(type, parent_decoder, NULL), video_audio_separate ? "[v+a]"
+	                                                               : type == VIDEO      ? "[v]"
+	                                                                                    : "[a]");
 
 	ffmpeg_result = av_seek_frame(format_context[type], stream_index[type], seek_timestamp, 0);
 	if (ffmpeg_result != 0) {
@@ -287,6 +348,22 @@ end:
 	av_packet_free(&test_packet);
 	return result;
 }
+void NetworkDecoderFFmpegIOData::import_keyframe_index(int type) {
+	for (int index_type = 0; index_type < 2; index_type++) {
+		if (video_audio_separate ? index_type != type : stream_index[index_type] < 0) {
+			continue;
+		}
+		AVStream *stream = format_context[type]->streams[stream_index[index_type]];
+		int entry_num = avformat_index_get_entries_count(stream);
+		for (int i = 0; i < entry_num; i++) {
+			const AVIndexEntry *entry = avformat_index_get_entry(stream, i);
+			if (entry->flags & AVINDEX_KEYFRAME) {
+				keyframe_index[index_type].add(av_rescale_q(entry->timestamp, stream->time_base, AV_TIME_BASE_Q),
+				                               entry->pos);
+			}
+		}
+	}
+}
 double NetworkDecoderFFmpegIOData::get_duration() {
 	return (double)format_context[video_audio_separate ? AUDIO : BOTH]->duration / AV_TIME_BASE;
 }
@@ -299,6 +376,39 @@ void NetworkDecoderFilterData::deinit() {
 	avfilter_graph_free(&audio_filter_graph);
 	av_frame_free(&output_frame);
 	audio_filter_src = audio_filter_sink = NULL;
+	tempo_filter_contexts.clear();
+	volume_filter_context = NULL;
+}
+static bool is_identity_value(double value) { return std::abs(1.0 - value) < 0.01; }
+static bool is_identity_equalizer(const volatile double *values) {
+	for (int i = 0; i < 18; i++) {
+		if (!is_identity_value(values[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+// the graph can be skipped when it would do nothing : every filter is identity and the decoder already outputs the
+// format of the speaker (shared by init() and is_topology_changed() so that they always agree)
+static bool can_bypass_filters(double volume, double tempo, double pitch, const volatile double *equalizer_values,
+                               const AVCodecContext *audio_context) {
+	return is_identity_value(volume) && is_identity_value(tempo) && is_identity_value(pitch) &&
+	       is_identity_equalizer(equalizer_values) && audio_context->sample_rate == 44100 &&
+	       audio_context->ch_layout.nb_channels == 2;
+}
+// atempo does not support a tempo lower than 0.5, so multiple atempo filters are chained in that case
+static std::vector<double> get_atempo_values(double tempo, double pitch) {
+	double atempo_value = tempo;
+	if (!is_identity_value(pitch)) {
+		atempo_value /= pitch; // asetrate changes the tempo as well
+	}
+	std::vector<double> res;
+	while (!is_identity_value(atempo_value)) {
+		double cur_tempo = std::max(0.5, atempo_value);
+		atempo_value /= cur_tempo;
+		res.push_back(cur_tempo);
+	}
+	return res;
 }
 Result_with_string NetworkDecoderFilterData::init(AVCodecContext *audio_context) {
 	Result_with_string result;
@@ -324,6 +434,11 @@ Result_with_string NetworkDecoderFilterData::init(AVCodecContext *audio_context)
 			goto fail;
 		}
 
+		bypass = can_bypass_filters(volume, tempo, pitch, equalizer_values, audio_context);
+		if (bypass) {
+			return result;
+		}
+
 		audio_filter_graph = avfilter_graph_alloc();
 		if (!audio_filter_graph) {
 			result.error_description = "avfilter_graph_alloc() failed ";
@@ -365,10 +480,8 @@ Result_with_string NetworkDecoderFilterData::init(AVCodecContext *audio_context)
 			goto fail;
 		}
 		filter_sequence.push_back(audio_filter_src);
-		double atempo_value = tempo;
 		// asetrate (simultaneous tempo/pitch shift)
-		if (std::abs(1.0 - pitch) >= 0.01) {
-			atempo_value /= pitch;
+		if (!is_identity_value(pitch)) {
 			AVFilterContext *audio_pitch_filter;
 			snprintf(option_buffer, 256, "sample_rate=%f", audio_context->sample_rate * pitch);
 			ffmpeg_result = avfilter_graph_create_filter(&audio_pitch_filter, asetrate, NULL, option_buffer, NULL,
@@ -381,10 +494,7 @@ Result_with_string NetworkDecoderFilterData::init(AVCodecContext *audio_context)
 		}
 
 		// atempo (tempo filter)
-		// atempo does not support a tempo lower than 0.5, so chain multiple atempo filters in that case
-		while (std::abs(1.0 - atempo_value) >= 0.01) {
-			double cur_tempo = std::max(0.5, atempo_value);
-			atempo_value /= cur_tempo;
+		for (double cur_tempo : get_atempo_values(tempo, pitch)) {
 			AVFilterContext *audio_tempo_filter;
 			snprintf(option_buffer, 256, "tempo=%f", cur_tempo);
 			ffmpeg_result = avfilter_graph_create_filter(&audio_tempo_filter, atempo, NULL, option_buffer, NULL,
@@ -394,6 +504,7 @@ Result_with_string NetworkDecoderFilterData::init(AVCodecContext *audio_context)
 				goto fail;
 			}
 			filter_sequence.push_back(audio_tempo_filter);
+			tempo_filter_contexts.push_back(audio_tempo_filter);
 		}
 		// aecho (echo filter)
 		/*
@@ -404,7 +515,7 @@ Result_with_string NetworkDecoderFilterData::init(AVCodecContext *audio_context)
 		}*/
 
 		// volume
-		if (std::abs(1.0 - volume) >= 0.01) {
+		if (!is_identity_value(volume)) {
 			AVFilterContext *audio_volume_filter;
 			snprintf(option_buffer, 256, "volume=%f", volume);
 			ffmpeg_result = avfilter_graph_create_filter(&audio_volume_filter, volume_filter, NULL, option_buffer, NULL,
@@ -414,15 +525,10 @@ Result_with_string NetworkDecoderFilterData::init(AVCodecContext *audio_context)
 				goto fail;
 			}
 			filter_sequence.push_back(audio_volume_filter);
+			volume_filter_context = audio_volume_filter;
 		}
 		// superequalizer
-		bool use_equalizer = false;
-		for (int i = 0; i < 18; i++) {
-			if (std::abs(1.0 - equalizer_values[i]) >= 0.01) {
-				use_equalizer = true;
-			}
-		}
-		if (use_equalizer) {
+		if (!is_identity_equalizer(equalizer_values)) {
 			AVFilterContext *superequalizer_filter;
 			char *head = option_buffer;
 			for (int i = 0; i < 18; i++) {
@@ -493,6 +599,81 @@ fail:
 	result.string = DEF_ERR_FFMPEG_RETURNED_NOT_SUCCESS_STR;
 	return result;
 }
+// whether the requested values need a graph with different filters (or filters without runtime commands changed)
+bool NetworkDecoderFilterData::is_topology_changed(const AVCodecContext *audio_context) {
+	if (pitch_request != pitch) { // asetrate has no runtime command
+		return true;
+	}
+	for (int i = 0; i < 18; i++) { // superequalizer has no runtime command
+		if (equalizer_values_request[i] != equalizer_values[i]) {
+			return true;
+		}
+	}
+	if (bypass != can_bypass_filters(volume_request, tempo_request, pitch_request, equalizer_values_request,
+	                                 audio_context)) {
+		return true;
+	}
+	return !bypass && (get_atempo_values(tempo_request, pitch_request).size() != tempo_filter_contexts.size() ||
+	                   is_identity_value(volume_request) != (volume_filter_context == NULL));
+}
+// makes the pts of the following output frames continue from the current position, used when the tempo changes
+void NetworkDecoderFilterData::rebase_timestamp() {
+	if (!first_frame) {
+		initial_timestamp += (double)received_frame_num / 44100 * tempo;
+		received_frame_num = 0;
+	}
+}
+Result_with_string NetworkDecoderFilterData::update(AVCodecContext *audio_context, bool *pending) {
+	Result_with_string result;
+	*pending = false;
+
+	if (is_topology_changed(audio_context)) {
+		double cur_time = (double)svcGetSystemTick() / SYSCLOCK_ARM11;
+		if (cur_time - last_rebuild_time < REBUILD_INTERVAL_MIN) {
+			*pending = true;
+			return result;
+		}
+		last_rebuild_time = cur_time;
+
+		rebase_timestamp();
+		bool first_frame_bak = first_frame;
+		double initial_timestamp_bak = initial_timestamp;
+		deinit();
+		result = init(audio_context);
+		if (!first_frame_bak) {
+			first_frame = false;
+			initial_timestamp = initial_timestamp_bak;
+		}
+		return result;
+	}
+
+	std::vector<double> atempo_values = get_atempo_values(tempo_request, pitch_request);
+	char arg[32];
+	for (size_t i = 0; i < tempo_filter_contexts.size(); i++) {
+		snprintf(arg, sizeof(arg), "%f", atempo_values[i]);
+		int ffmpeg_result = avfilter_process_command(tempo_filter_contexts[i], "tempo", arg, NULL, 0, 0);
+		if (ffmpeg_result < 0) {
+			result.code = DEF_ERR_FFMPEG_RETURNED_NOT_SUCCESS;
+			result.string = DEF_ERR_FFMPEG_RETURNED_NOT_SUCCESS_STR;
+			result.error_description = "atempo command failed : " + std::to_string(ffmpeg_result);
+			return result;
+		}
+	}
+	if (volume_filter_context) {
+		snprintf(arg, sizeof(arg), "%f", (double)volume_request);
+		int ffmpeg_result = avfilter_process_command(volume_filter_context, "volume", arg, NULL, 0, 0);
+		if (ffmpeg_result < 0) {
+			result.code = DEF_ERR_FFMPEG_RETURNED_NOT_SUCCESS;
+			result.string = DEF_ERR_FFMPEG_RETURNED_NOT_SUCCESS_STR;
+			result.error_description = "volume command failed : " + std::to_string(ffmpeg_result);
+			return result;
+		}
+	}
+	rebase_timestamp();
+	volume = volume_request;
+	tempo = tempo_request;
+	return result;
+}
 Result_with_string NetworkDecoderFilterData::process_audio_frame(AVFrame *input, double *out_pts) {
 	Result_with_string result;
 	int ffmpeg_result = 0;
@@ -501,6 +682,18 @@ Result_with_string NetworkDecoderFilterData::process_audio_frame(AVFrame *input,
 		first_frame = false, initial_timestamp = input->pts * input_time_base;
 	}
 
+	if (bypass) {
+		av_frame_unref(output_frame);
+		ffmpeg_result = av_frame_ref(output_frame, input);
+		if (ffmpeg_result < 0) {
+			result.error_description = "av_frame_ref() failed : " + std::to_string(ffmpeg_result);
+			goto fail;
+		}
+		*out_pts = initial_timestamp + (double)received_frame_num / 44100 * tempo;
+		received_frame_num += output_frame->nb_samples;
+		return result;
+	}
+
 	ffmpeg_result = av_buffersrc_write_frame(audio_filter_src, input);
 	if (ffmpeg_result < 0) {
 		result.error_description = "av_buffersrc_write_frame() failed : " + std::to_string(ffmpeg_result);
@@ -538,26 +731,45 @@ void NetworkDecoder::deinit() {
 	// ensure the UI thread will see ready == false after locking the mutex durning deiniting
 	critical_op_lock.lock();
 	critical_op_lock.unlock();
+	// wait for the demux thread to finish the packet it may be reading
+	demux_lock.lock();
+	demux_lock.unlock();
 
+	packet_buffer_lock.lock();
 	for (int type = 0; type < 2; type++) {
-		for (auto i : packet_buffer[type]) {
-			av_packet_free(&i);
+		for (size_t i = 0; i < packet_buffer[type].size(); i++) {
+			packet_pool.release(packet_buffer[type][i]);
 		}
 		packet_buffer[type].clear();
-	}
+		packet_buffer_bytes[type] = 0;
+	}
+	packet_buffer_lock.unlock();
+	logger.info("net/dec", "pool high-water marks : " + std::to_string(packet_pool.get_high_water_mark()) +
+	                           " packets, " + std::to_string(frame_pool.get_high_water_mark()) + " frames");
+	packet_buffer_lock.lock();
+	packet_pool.deinit();
+	packet_buffer_lock.unlock();
+	frame_pool.deinit();
 	// for HW decoder
 	for (auto i : video_mvd_tmp_frames.deinit()) {
 		free(i);
 	}
 	linearFree_concurrent(mvd_frame);
 	mvd_frame = NULL;
-	buffered_pts_list.clear();
+	mvd_pending_pts.clear();
 	// for SW decoder
 	for (auto i : video_tmp_frames.deinit()) {
 		av_frame_free(&i);
 	}
 	free(sw_video_output_tmp);
 	sw_video_output_tmp = NULL;
+	av_frame_free(&sw_video_output_frame);
+	for (int i = 0; i < SW_VIDEO_OUTPUT_BUFFER_NUM; i++) {
+		free(sw_video_output[i]);
+		sw_video_output[i] = NULL;
+	}
+	sw_video_output_size = 0;
+	sw_video_output_head = 0;
 
 	// its members should be freed by NetworkMultipleDecoder, not here
 	// just to prevent use-after-free, we set the pointer to NULL
@@ -570,6 +782,33 @@ void NetworkDecoder::deinit() {
 	swr_free(&swr_context);
 }
 
+void NetworkDecoder::request_interrupt() {
+	interrupt = true;
+	critical_op_lock.lock();
+	if (io) {
+		for (int type = 0; type < 2; type++) {
+			if (io->network_stream[type]) {
+				io->network_stream[type]->data_event.signal();
+			}
+		}
+	}
+	critical_op_lock.unlock();
+	packet_event.signal();
+	demux_event.signal();
+}
+void NetworkDecoder::change_ffmpeg_io_data(NetworkDecoderFFmpegIOData &ffmpeg_io_data, double timestamp_offset) {
+	interrupt = false;
+	this->io = &ffmpeg_io_data;
+	this->timestamp_offset = timestamp_offset;
+	for (int type = 0; type < 2; type++) {
+		if (io->stream_index[type] >= 0) {
+			stream_time_base[type] = av_q2d(get_stream(type)->time_base);
+		}
+		demux_failed[type] = false;
+	}
+	demux_event.signal();
+}
+
 Result_with_string NetworkDecoder::init_output_buffer(bool is_mvd) {
 	Result_with_string result;
 	int width, height;
@@ -626,6 +865,11 @@ Result_with_string NetworkDecoder::init_output_buffer(bool is_mvd) {
 			result.error_description = "malloc() failed while preallocating ";
 			goto fail;
 		}
+		sw_video_output_frame = av_frame_alloc();
+		if (!sw_video_output_frame) {
+			result.error_description = "av_frame_alloc() failed while preallocating ";
+			goto fail;
+		}
 	}
 
 	return result;
@@ -720,6 +964,7 @@ Result_with_string NetworkDecoder::init(bool request_hw_decoder) {
 
 	hw_decoder_enabled = request_hw_decoder;
 	interrupt = false;
+	skip_non_ref_frames = skip_non_ref_frames_request = false;
 
 	// init decoder
 	if (!is_audio_only()) {
@@ -741,15 +986,23 @@ Result_with_string NetworkDecoder::init(bool request_hw_decoder) {
 	return result;
 }
 void NetworkDecoder::clear_buffer() {
+	packet_buffer_lock.lock();
 	for (int type = 0; type < 2; type++) {
-		for (auto i : packet_buffer[type]) {
-			av_packet_free(&i);
+		for (size_t i = 0; i < packet_buffer[type].size(); i++) {
+			packet_pool.release(packet_buffer[type][i]);
 		}
 		packet_buffer[type].clear();
+		packet_buffer_bytes[type] = 0;
+		demux_failed[type] = false;
 	}
+	packet_buffer_lock.unlock();
+	demux_event.signal();
 	video_mvd_tmp_frames.clear();
 	video_tmp_frames.clear();
-	buffered_pts_list.clear();
+	if (sw_video_output_frame) {
+		av_frame_unref(sw_video_output_frame);
+	}
+	mvd_pending_pts.clear();
 }
 
 NetworkDecoder::VideoFormatInfo NetworkDecoder::get_video_info() {
@@ -809,7 +1062,9 @@ Result_with_string NetworkDecoder::read_packet(int type) {
 	Result_with_string result;
 	int ffmpeg_result;
 
-	AVPacket *tmp_packet = av_packet_alloc();
+	packet_buffer_lock.lock();
+	AVPacket *tmp_packet = packet_pool.acquire();
+	packet_buffer_lock.unlock();
 	if (!tmp_packet) {
 		result.code = DEF_ERR_OUT_OF_MEMORY;
 		result.string = DEF_ERR_OUT_OF_MEMORY_STR;
@@ -845,28 +1100,136 @@ Result_with_string NetworkDecoder::read_packet(int type) {
 	{
 		int packet_type =
 		    is_av_separate() ? type : (tmp_packet->stream_index == io->stream_index[VIDEO] ? VIDEO : AUDIO);
+		if (tmp_packet->flags & AV_PKT_FLAG_KEY) {
+			s64 timestamp = tmp_packet->pts != AV_NOPTS_VALUE ? tmp_packet->pts : tmp_packet->dts;
+			if (timestamp != AV_NOPTS_VALUE) {
+				io->keyframe_index[packet_type].add(
+				    av_rescale_q(timestamp, get_stream(packet_type)->time_base, AV_TIME_BASE_Q), tmp_packet->pos);
+			}
+		}
+		packet_buffer_lock.lock();
 		packet_buffer[packet_type].push_back(tmp_packet);
+		packet_buffer_bytes[packet_type] += tmp_packet->size;
+		packet_buffer_lock.unlock();
+		packet_event.signal();
 		return result;
 	}
 
 ffmpeg_fail:
-	av_packet_free(&tmp_packet);
+	packet_buffer_lock.lock();
+	packet_pool.release(tmp_packet);
+	packet_buffer_lock.unlock();
 	result.code = DEF_ERR_FFMPEG_RETURNED_NOT_SUCCESS;
 	result.string = DEF_ERR_FFMPEG_RETURNED_NOT_SUCCESS_STR;
 	return result;
 reinit_fail:
+	packet_buffer_lock.lock();
+	packet_pool.release(tmp_packet);
+	packet_buffer_lock.unlock();
 	logger.error("debug", "avformat reinit fail : " + result.error_description);
 	return result;
 }
+size_t NetworkDecoder::get_packet_num(int type) {
+	packet_buffer_lock.lock();
+	size_t res = packet_buffer[type].size();
+	packet_buffer_lock.unlock();
+	return res;
+}
+AVPacket *NetworkDecoder::peek_packet(int type) {
+	packet_buffer_lock.lock();
+	AVPacket *res = packet_buffer[type].size() ? packet_buffer[type][0] : NULL;
+	packet_buffer_lock.unlock();
+	return res;
+}
+void NetworkDecoder::pop_packet(int type) {
+	packet_buffer_lock.lock();
+	if (packet_buffer[type].size()) {
+		packet_buffer_bytes[type] -= packet_buffer[type][0]->size;
+		packet_pool.release(packet_buffer[type][0]);
+		packet_buffer[type].pop_front();
+	}
+	packet_buffer_lock.unlock();
+	demux_event.signal();
+}
+bool NetworkDecoder::is_packet_queue_full(int type) {
+	packet_buffer_lock.lock();
+	bool res = packet_buffer[type].size() >= PACKET_QUEUE_MAX || packet_buffer_bytes[type] >= PACKET_QUEUE_MAX_BYTES;
+	packet_buffer_lock.unlock();
+	return res;
+}
+void NetworkDecoder::refill_packets(int type) {
+	if (demux_thread_running) {
+		return;
+	}
+	while (!get_packet_num(type) && read_packet(is_av_separate() ? type : BOTH).code == 0)
+		;
+}
+NetworkDecoder::PacketQueueDepth NetworkDecoder::get_packet_queue_depth() {
+	PacketQueueDepth res;
+	res.video = get_packet_num(VIDEO);
+	res.audio = get_packet_num(AUDIO);
+	return res;
+}
+
+bool NetworkDecoder::is_stream_finished(int type) {
+	NetworkStream *stream = io->network_stream[type];
+	return stream && ((stream->ready && stream->read_head >= stream->len) || stream->error || stream->quit_request);
+}
+bool NetworkDecoder::demux_packets() {
+	bool res = false;
+	demux_lock.lock();
+	if (ready && !interrupt) {
+		double cur_time = (double)svcGetSystemTick() / SYSCLOCK_ARM11;
+		// a finished stream is not read again until a seek or a change of the io data clears the flag, otherwise the
+		// demux thread would spin on it
+		auto can_read = [&](int type) {
+			return !demux_failed[type] ||
+			       (!is_stream_finished(type) && cur_time - demux_failed_time[type] >= DEMUX_RETRY_INTERVAL);
+		};
+		auto read = [&](int type) {
+			demux_failed[type] = read_packet(type).code != 0;
+			if (demux_failed[type]) {
+				demux_failed_time[type] = cur_time;
+				packet_event.signal();
+			}
+			res = true;
+		};
+		if (is_av_separate()) {
+			for (int type = 0; type < 2; type++) {
+				if ((type == VIDEO && is_audio_only()) || !can_read(type) || is_packet_queue_full(type)) {
+					continue;
+				}
+				read(type);
+			}
+		} else if (can_read(BOTH) &&
+		           (!is_packet_queue_full(AUDIO) || (!is_audio_only() && !is_packet_queue_full(VIDEO)))) {
+			read(BOTH);
+		}
+	}
+	demux_lock.unlock();
+	return res;
+}
+
 NetworkDecoder::PacketType NetworkDecoder::next_decode_type() {
-	if (is_av_separate()) {
+	if (demux_thread_running) {
+		// decoding only blocks here, when the queue of a stream is empty and the demux thread is still reading it
+		auto is_waiting_for = [&](int type) {
+			if (type == VIDEO && is_audio_only()) {
+				return false;
+			}
+			return !get_packet_num(type) && !demux_failed[is_av_separate() ? type : BOTH];
+		};
+		while (ready && !interrupt && (is_waiting_for(VIDEO) || is_waiting_for(AUDIO))) {
+			packet_event.wait(PACKET_WAIT_TIMEOUT_NS);
+		}
+	} else if (is_av_separate()) {
 		for (int type = 0; type < 2; type++) {
-			if (!packet_buffer[type].size()) {
+			if (!get_packet_num(type)) {
 				read_packet(type);
 			}
 		}
 	} else {
-		while ((!is_audio_only() && !packet_buffer[VIDEO].size()) || !packet_buffer[AUDIO].size()) {
+		while ((!is_audio_only() && !get_packet_num(VIDEO)) || !get_packet_num(AUDIO)) {
 			Result_with_string result = read_packet(BOTH);
 			if (result.code != 0) {
 				break;
@@ -874,43 +1237,33 @@ NetworkDecoder::PacketType NetworkDecoder::next_decode_type() {
 		}
 	}
 
-	bool video_empty = packet_buffer[VIDEO].empty();
-	bool audio_empty = packet_buffer[AUDIO].empty();
+	AVPacket *video_packet = peek_packet(VIDEO);
+	AVPacket *audio_packet = peek_packet(AUDIO);
+	bool video_empty = !video_packet;
+	bool audio_empty = !audio_packet;
 	bool video_decoded_empty = video_tmp_frames.empty() && video_mvd_tmp_frames.empty();
 
-	// Check if the stream reached EOF
-	auto is_stream_eof = [&](int type) {
-		auto stream = io->network_stream[type];
-		return stream && stream->ready && stream->read_head >= stream->len;
-	};
-	// Check if the stream has error or quit request
-	auto is_stream_error_or_quit = [&](int type) {
-		auto stream = io->network_stream[type];
-		return stream && (stream->error || stream->quit_request);
-	};
-
 	if (video_empty && audio_empty && video_decoded_empty) {
 		if (is_av_separate()) {
-			if ((is_stream_eof(VIDEO) || is_stream_error_or_quit(VIDEO))
-			&& (is_stream_eof(AUDIO) || is_stream_error_or_quit(AUDIO))) {
+			if (is_stream_finished(VIDEO) && is_stream_finished(AUDIO)) {
 				return PacketType::EoF;
 			}
 		} else {
-			if (is_stream_eof(BOTH) || is_stream_error_or_quit(BOTH)) {
+			if (is_stream_finished(BOTH)) {
 				return PacketType::EoF;
 			}
 		}
 		return PacketType::None;
 	}
 
-	if (!packet_buffer[AUDIO].size()) {
+	if (audio_empty) {
 		return PacketType::VIDEO;
 	}
-	if (!packet_buffer[VIDEO].size()) {
+	if (video_empty) {
 		return PacketType::AUDIO;
 	}
-	double video_dts = packet_buffer[VIDEO][0]->dts * av_q2d(get_stream(VIDEO)->time_base);
-	double audio_dts = packet_buffer[AUDIO][0]->dts * av_q2d(get_stream(AUDIO)->time_base);
+	double video_dts = video_packet->dts * stream_time_base[VIDEO];
+	double audio_dts = audio_packet->dts * stream_time_base[AUDIO];
 	return video_dts <= audio_dts ? PacketType::VIDEO : PacketType::AUDIO;
 }
 Result_with_string NetworkDecoder::mvd_decode(int *width, int *height) {
@@ -931,7 +1284,7 @@ Result_with_string NetworkDecoder::mvd_decode(int *width, int *height) {
 	int offset = 0;
 	int source_offset = 0;
 
-	AVPacket *packet_read = packet_buffer[VIDEO][0];
+	AVPacket *packet_read = peek_packet(VIDEO);
 	u8 *mvd_packet = (u8 *)linearAlloc_concurrent(packet_read->size);
 	if (mvd_first) {
 		// set extra data
@@ -999,16 +1352,14 @@ Result_with_string NetworkDecoder::mvd_decode(int *width, int *height) {
 
 	if (MVD_CHECKNALUPROC_SUCCESS(result.code)) {
 		double cur_pos;
-		double time_base = av_q2d(get_stream(VIDEO)->time_base);
+		double time_base = stream_time_base[VIDEO];
 		if (packet_read->pts != AV_NOPTS_VALUE) {
 			cur_pos = packet_read->pts * time_base;
 		} else {
 			cur_pos = packet_read->dts * time_base;
 		}
 
-		buffered_pts_list_lock.lock();
-		buffered_pts_list.insert(cur_pos + timestamp_offset);
-		buffered_pts_list_lock.unlock();
+		mvd_pending_pts.push(cur_pos + timestamp_offset);
 	}
 	if (result.code == MVD_STATUS_FRAMEREADY) {
 		result.code = 0;
@@ -1016,7 +1367,7 @@ Result_with_string NetworkDecoder::mvd_decode(int *width, int *height) {
 
 		if (!mvd_first) { // when changing video, it somehow outputs a frame of previous video, so ignore the first one
 			memcpy_asm(video_mvd_tmp_frames.get_next_pushed(), mvd_frame, (*width * *height * 2) / 32 * 32);
-			video_mvd_tmp_frames.push();
+			video_mvd_tmp_frames.push(mvd_pending_pts.size() ? mvd_pending_pts.pop() : 0);
 		}
 	} else {
 		logger.caution("", "mvdstdProcessVideoFrame()...", result.code);
@@ -1025,11 +1376,8 @@ Result_with_string NetworkDecoder::mvd_decode(int *width, int *height) {
 	mvd_first = false;
 	linearFree_concurrent(mvd_packet);
 	mvd_packet = NULL;
-	av_packet_free(&packet_read);
-	packet_buffer[VIDEO].pop_front();
-	// refill the packet buffer
-	while (!packet_buffer[VIDEO].size() && read_packet(is_av_separate() ? VIDEO : BOTH).code == 0)
-		;
+	pop_packet(VIDEO);
+	refill_packets(VIDEO);
 
 	return result;
 }
@@ -1037,12 +1385,11 @@ Result_with_string NetworkDecoder::decode_video(int *width, int *height, bool *k
 	Result_with_string result;
 	int ffmpeg_result = 0;
 
-	if (packet_buffer[VIDEO].empty()) {
+	AVPacket *packet_read = peek_packet(VIDEO);
+	if (!packet_read) {
 		result.code = DEF_ERR_NEED_MORE_INPUT;
 		return result;
 	}
-
-	AVPacket *packet_read = packet_buffer[VIDEO][0];
 	*key_frame = (packet_read->flags & AV_PKT_FLAG_KEY);
 
 	if (hw_decoder_enabled) {
@@ -1062,6 +1409,13 @@ Result_with_string NetworkDecoder::decode_video(int *width, int *height, bool *k
 	*width = 0;
 	*height = 0;
 
+	if (skip_non_ref_frames != skip_non_ref_frames_request) {
+		skip_non_ref_frames = skip_non_ref_frames_request;
+		decoder_context[VIDEO]->skip_frame = skip_non_ref_frames ? AVDISCARD_NONREF : AVDISCARD_DEFAULT;
+		decoder_context[VIDEO]->skip_loop_filter = skip_non_ref_frames ? AVDISCARD_ALL : AVDISCARD_DEFAULT;
+		logger.info("net/dec", std::string("non-reference frame skipping ") + (skip_non_ref_frames ? "on" : "off"));
+	}
+
 	AVFrame *cur_frame = video_tmp_frames.get_next_pushed();
 
 	ffmpeg_result = avcodec_send_packet(decoder_context[VIDEO], packet_read);
@@ -1071,7 +1425,7 @@ Result_with_string NetworkDecoder::decode_video(int *width, int *height, bool *k
 			*width = cur_frame->width;
 			*height = cur_frame->height;
 
-			double time_base = av_q2d(get_stream(VIDEO)->time_base);
+			double time_base = stream_time_base[VIDEO];
 			double cur_pos;
 			if (cur_frame->pts != AV_NOPTS_VALUE) {
 				cur_pos = cur_frame->pts * time_base;
@@ -1080,11 +1434,7 @@ Result_with_string NetworkDecoder::decode_video(int *width, int *height, bool *k
 			}
 			cur_pos += timestamp_offset;
 
-			buffered_pts_list_lock.lock();
-			buffered_pts_list.insert(cur_pos);
-			buffered_pts_list_lock.unlock();
-
-			video_tmp_frames.push();
+			video_tmp_frames.push(cur_pos);
 		} else if (ffmpeg_result == AVERROR(EAGAIN)) {
 			result.code = DEF_ERR_NEED_MORE_INPUT;
 		} else {
@@ -1098,27 +1448,24 @@ Result_with_string NetworkDecoder::decode_video(int *width, int *height, bool *k
 		result.error_description = "avcodec_send_packet() failed " + std::to_string(ffmpeg_result);
 	}
 
-	av_packet_free(&packet_read);
-	packet_buffer[VIDEO].pop_front();
-	// refill the packet buffer
-	while (!packet_buffer[VIDEO].size() && read_packet(is_av_separate() ? VIDEO : BOTH).code == 0)
-		;
+	pop_packet(VIDEO);
+	refill_packets(VIDEO);
 
 	return result;
 }
-Result_with_string NetworkDecoder::decode_audio(int *size, u8 **data, double *cur_pos) {
+Result_with_string NetworkDecoder::decode_audio(int *size, u8 **data, double *cur_pos,
+                                                const std::function<u8 *(int size)> &get_output_buffer) {
 	int ffmpeg_result = 0;
 	Result_with_string result;
 	*size = 0;
 
-	if (packet_buffer[AUDIO].empty()) {
+	AVPacket *packet_read = peek_packet(AUDIO);
+	if (!packet_read) {
 		result.code = DEF_ERR_NEED_MORE_INPUT;
 		return result;
 	}
 
-	AVPacket *packet_read = packet_buffer[AUDIO][0];
-
-	AVFrame *cur_frame = av_frame_alloc();
+	AVFrame *cur_frame = frame_pool.acquire();
 	if (!cur_frame) {
 		result.error_description = "av_frame_alloc() failed";
 		goto ffmpeg_fail;
@@ -1133,7 +1480,12 @@ Result_with_string NetworkDecoder::decode_audio(int *size, u8 **data, double *cu
 				goto cleanup;
 			}
 			auto out_frame = filter.output_frame;
-			*data = (u8 *)malloc(out_frame->nb_samples * 2 * decoder_context[AUDIO]->channels);
+			u8 *output = get_output_buffer(out_frame->nb_samples * 2 * decoder_context[AUDIO]->channels);
+			if (!output) {
+				result.code = DEF_ERR_NEED_MORE_OUTPUT;
+				goto cleanup;
+			}
+			*data = output;
 			*size = 2 * swr_convert(swr_context, data, out_frame->nb_samples, (const u8 **)out_frame->data,
 			                        out_frame->nb_samples);
 			*cur_pos += timestamp_offset;
@@ -1153,11 +1505,11 @@ ffmpeg_fail:
 	result.string = DEF_ERR_FFMPEG_RETURNED_NOT_SUCCESS_STR;
 
 cleanup:
-	av_packet_free(&packet_read);
-	packet_buffer[AUDIO].pop_front();
-	while (!packet_buffer[AUDIO].size() && read_packet(is_av_separate() ? AUDIO : BOTH).code == 0)
-		;
-	av_frame_free(&cur_frame);
+	pop_packet(AUDIO);
+	refill_packets(AUDIO);
+	if (cur_frame) {
+		frame_pool.release(cur_frame);
+	}
 	return result;
 }
 
@@ -1170,40 +1522,99 @@ Result_with_string NetworkDecoder::get_decoded_video_frame(int width, int height
 			return result;
 		}
 		*data = video_mvd_tmp_frames.get_next_poped(); // it's valid until the next pop() is called
+		*cur_pos = video_mvd_tmp_frames.get_next_poped_pts();
 		video_mvd_tmp_frames.pop();
 	} else {
 		if (video_tmp_frames.empty()) {
 			result.code = DEF_ERR_NEED_MORE_INPUT;
 			return result;
 		}
+		// the frame is kept as it is (instead of being copied out) until convert_decoded_video_frame()
 		AVFrame *cur_frame = video_tmp_frames.get_next_poped();
+		av_frame_unref(sw_video_output_frame);
+		av_frame_move_ref(sw_video_output_frame, cur_frame);
+		*cur_pos = video_tmp_frames.get_next_poped_pts();
 		video_tmp_frames.pop();
 
-		int cpy_size[2] = {
-		    0,
-		    0,
-		};
-
-		cpy_size[0] = (width * height);
-		cpy_size[1] = cpy_size[0] / 4;
-		cpy_size[0] -= cpy_size[0] % 32;
-		cpy_size[1] -= cpy_size[1] % 32;
+		*data = NULL;
+	}
 
-		memcpy_asm(sw_video_output_tmp, cur_frame->data[0], cpy_size[0]);
-		memcpy_asm(sw_video_output_tmp + (width * height), cur_frame->data[1], cpy_size[1]);
-		memcpy_asm(sw_video_output_tmp + (width * height) + (width * height / 4), cur_frame->data[2], cpy_size[1]);
+	return result;
+}
 
-		*data = sw_video_output_tmp;
+// whether Y2R can read the planes of the frame as they are : the line sizes must be usable as the transfer gaps, and
+// the buffers must have enough lines for the (16-aligned) height
+static bool is_directly_convertible(AVFrame *frame, int width, int height) {
+	if (frame->linesize[1] != frame->linesize[2]) {
+		return false;
+	}
+	for (int plane = 0; plane < 3; plane++) {
+		int line_width = plane ? width / 2 : width;
+		int lines = plane ? height / 2 : height;
+		AVBufferRef *buffer = av_frame_get_plane_buffer(frame, plane);
+		if (!buffer || frame->linesize[plane] < line_width || frame->linesize[plane] - line_width > INT16_MAX) {
+			return false;
+		}
+		if (frame->data[plane] + (size_t)frame->linesize[plane] * (lines - 1) + line_width >
+		    buffer->data + buffer->size) {
+			return false;
+		}
+	}
+	return true;
+}
+Result_with_string NetworkDecoder::convert_decoded_video_frame(int width, int height, u8 **data) {
+	Result_with_string result;
+	AVFrame *frame = sw_video_output_frame;
+	if (!frame || !frame->data[0]) {
+		result.code = DEF_ERR_OTHER;
+		result.string = DEF_ERR_OTHER_STR;
+		result.error_description = "no frame to convert";
+		return result;
+	}
 
-		av_frame_unref(cur_frame);
+	size_t output_size = width * height * 2;
+	if (sw_video_output_size < output_size) {
+		for (int i = 0; i < SW_VIDEO_OUTPUT_BUFFER_NUM; i++) {
+			free(sw_video_output[i]);
+			sw_video_output[i] = (u8 *)memalign(SW_VIDEO_OUTPUT_ALIGN, output_size);
+			video_output_stats.alloc_num++;
+			if (!sw_video_output[i]) {
+				sw_video_output_size = 0;
+				av_frame_unref(frame);
+				result.code = DEF_ERR_OUT_OF_MEMORY;
+				result.string = DEF_ERR_OUT_OF_MEMORY_STR;
+				return result;
+			}
+		}
+		sw_video_output_size = output_size;
 	}
+	u8 *output = sw_video_output[sw_video_output_head];
+	sw_video_output_head = (sw_video_output_head + 1) % SW_VIDEO_OUTPUT_BUFFER_NUM;
 
-	buffered_pts_list_lock.lock();
-	my_assert(buffered_pts_list.size());
-	*cur_pos = *buffered_pts_list.begin();
-	buffered_pts_list.erase(buffered_pts_list.begin());
-	buffered_pts_list_lock.unlock();
+	if (is_directly_convertible(frame, width, height)) {
+		result = Util_converter_y2r_yuv420p_to_bgr565(frame->data[0], frame->data[1], frame->data[2],
+		                                              frame->linesize[0], frame->linesize[1], output, width, height,
+		                                              false);
+	} else {
+		// pack the planes into the preallocated buffer first
+		u8 *planes[3] = {sw_video_output_tmp, sw_video_output_tmp + (width * height),
+		                 sw_video_output_tmp + (width * height) + (width * height / 4)};
+		for (int plane = 0; plane < 3; plane++) {
+			int line_width = plane ? width / 2 : width;
+			int lines = std::min(plane ? height / 2 : height, plane ? (frame->height + 1) / 2 : frame->height);
+			int copy_width = std::min(line_width, std::abs(frame->linesize[plane]));
+			for (int i = 0; i < lines; i++) {
+				memcpy(planes[plane] + i * line_width, frame->data[plane] + i * frame->linesize[plane], copy_width);
+			}
+		}
+		result = Util_converter_y2r_yuv420p_to_bgr565(planes[0], planes[1], planes[2], width, width / 2, output, width,
+		                                              height, false);
+		video_output_stats.copied_frame_num++;
+	}
+	av_frame_unref(frame);
+	video_output_stats.frame_num++;
 
+	*data = output;
 	return result;
 }
 
@@ -1215,6 +1626,27 @@ Result_with_string NetworkDecoder::seek(s64 microseconds) {
 	s64 min_ts = std::max<s64>(0, microseconds - 1000000);
 	s64 max_ts = microseconds + 500000;
 
+	// if the keyframe to land on is already indexed, the seek window is widened to include it so that the first
+	// attempt succeeds, and the blocks at the keyframe are requested for every stream before ffmpeg starts reading
+	// a keyframe farther than SEEK_KEYFRAME_DISTANCE_MAX is not used, as moving the read heads there would make the
+	// downloader fetch (and keep) blocks that are never read
+	network_decoder_::keyframe_index::Entry keyframe;
+	int index_type = is_audio_only() ? AUDIO : VIDEO;
+	if (io->keyframe_index[index_type].find(microseconds, SEEK_KEYFRAME_DISTANCE_MAX, &keyframe)) {
+		min_ts = std::min(min_ts, keyframe.timestamp);
+		if (io->network_stream[index_type] && (u64)keyframe.pos < io->network_stream[index_type]->len) {
+			io->network_stream[index_type]->set_read_head(keyframe.pos);
+		}
+		network_decoder_::keyframe_index::Entry audio_keyframe;
+		NetworkStream *audio_stream = io->network_stream[AUDIO];
+		if (is_av_separate() && audio_stream &&
+		    io->keyframe_index[AUDIO].find(keyframe.timestamp, SEEK_KEYFRAME_DISTANCE_MAX, &audio_keyframe) &&
+		    (u64)audio_keyframe.pos < audio_stream->len) {
+			audio_stream->set_read_head(audio_keyframe.pos);
+		}
+		logger.info("seek", "indexed keyframe at " + std::to_string(keyframe.timestamp / 1000) + " ms");
+	}
+
 	if (is_av_separate()) {
 		int ffmpeg_result = avformat_seek_file(io->format_context[VIDEO], -1, min_ts, microseconds, max_ts,
 		                                       AVSEEK_FLAG_FRAME); // AVSEEK_FLAG_FRAME <- ?
@@ -1240,11 +1672,12 @@ Result_with_string NetworkDecoder::seek(s64 microseconds) {
 		}
 
 		// once successfully sought on video, perform an exact seek on audio
-		double time_base = av_q2d(get_stream(VIDEO)->time_base);
-		if (packet_buffer[VIDEO][0]->pts != AV_NOPTS_VALUE) {
-			microseconds = packet_buffer[VIDEO][0]->pts * time_base * 1000000;
+		AVPacket *first_packet = peek_packet(VIDEO);
+		double time_base = stream_time_base[VIDEO];
+		if (first_packet->pts != AV_NOPTS_VALUE) {
+			microseconds = first_packet->pts * time_base * 1000000;
 		} else {
-			microseconds = packet_buffer[VIDEO][0]->dts * time_base * 1000000;
+			microseconds = first_packet->dts * time_base * 1000000;
 		}
 
 		ffmpeg_result = avformat_seek_file(io->format_context[AUDIO], -1, microseconds, microseconds, microseconds,
@@ -1282,7 +1715,7 @@ Result_with_string NetworkDecoder::seek(s64 microseconds) {
 			avcodec_flush_buffers(decoder_context[VIDEO]);
 		}
 		avcodec_flush_buffers(decoder_context[AUDIO]);
-		while ((!is_audio_only() && !packet_buffer[VIDEO].size()) || !packet_buffer[AUDIO].size()) {
+		while ((!is_audio_only() && !get_packet_num(VIDEO)) || !get_packet_num(AUDIO)) {
 			result = read_packet(BOTH);
 			if (result.code != 0) {
 				return result;
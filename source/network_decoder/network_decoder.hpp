@@ -4,6 +4,8 @@
 #include <vector>
 #include <set>
 #include <deque>
+#include <algorithm>
+#include <functional>
 #include <string.h>
 
 #include "system/fake_pthread.hpp"
@@ -21,12 +23,13 @@ extern "C" {
 
 namespace network_decoder_ {
 /*
-    internal queue used to buffer the raw output of decoded images
+    internal queue used to buffer the raw output of decoded images, along with their pts
     thread-safe when one thread only pushes and the other thread pops
 */
 template <typename T> class output_buffer {
 	size_t num = 0;
 	std::vector<T> buffer;
+	std::vector<double> pts;  // pts[i] : the pts of buffer[i]
 	volatile size_t head = 0; // the index of the element in the buffer which the next pushed element should go in
 	volatile size_t tail = 0; // the index of the element in the buffer which should be poped next
 
@@ -34,11 +37,13 @@ template <typename T> class output_buffer {
 	void init(const std::vector<T> &buffer_init) {
 		num = buffer_init.size() - 1;
 		buffer = buffer_init;
+		pts.assign(buffer_init.size(), 0);
 		head = tail = 0;
 	}
 	std::vector<T> deinit() {
 		auto res = buffer;
 		buffer.clear();
+		pts.clear();
 		num = 0;
 		head = tail = 0;
 		return res;
@@ -60,10 +65,11 @@ template <typename T> class output_buffer {
 		}
 		return buffer[head];
 	}
-	bool push() {
+	bool push(double elem_pts) {
 		if (full()) {
 			return false;
 		}
+		pts[head] = elem_pts;
 		head = (head == num ? 0 : head + 1);
 		return true;
 	}
@@ -73,6 +79,7 @@ template <typename T> class output_buffer {
 		}
 		return buffer[tail];
 	}
+	double get_next_poped_pts() { return empty() ? 0 : pts[tail]; }
 	bool pop() {
 		if (empty()) {
 			return false;
@@ -82,6 +89,160 @@ template <typename T> class output_buffer {
 	}
 	void clear() { head = tail; }
 };
+
+/*
+    FIFO queue on a ring buffer, used in place of std::deque to avoid allocations on every push
+    the capacity is doubled only when it becomes full
+*/
+template <typename T> class ring_queue {
+	std::vector<T> buffer;
+	size_t front = 0; // the index of the first element in the buffer
+	size_t num = 0;
+
+  public:
+	explicit ring_queue(size_t capacity = 64) : buffer(capacity) {}
+	size_t size() const { return num; }
+	bool empty() const { return num == 0; }
+	T &operator[](size_t i) { return buffer[(front + i) % buffer.size()]; }
+	void push_back(const T &elem) {
+		if (num == buffer.size()) {
+			std::vector<T> new_buffer(buffer.size() * 2);
+			for (size_t i = 0; i < num; i++) {
+				new_buffer[i] = (*this)[i];
+			}
+			buffer.swap(new_buffer);
+			front = 0;
+		}
+		buffer[(front + num) % buffer.size()] = elem;
+		num++;
+	}
+	void pop_front() {
+		front = (front + 1) % buffer.size();
+		num--;
+	}
+	void clear() { front = num = 0; }
+};
+
+/*
+    min-heap on a fixed array, used to reorder the pts of packets in decoding order into presentation order
+    when it's full, the smallest element is dropped
+    not thread-safe
+*/
+template <size_t N> class pts_reorder_buffer {
+	double heap[N];
+	size_t num = 0;
+
+  public:
+	size_t size() { return num; }
+	void clear() { num = 0; }
+	void push(double pts) {
+		if (num == N) {
+			pop();
+		}
+		heap[num++] = pts;
+		std::push_heap(heap, heap + num, std::greater<double>());
+	}
+	// returns the smallest element and removes it, must not be empty
+	double pop() {
+		std::pop_heap(heap, heap + num, std::greater<double>());
+		return heap[--num];
+	}
+};
+
+/*
+    sorted list of (timestamp, byte position) of the keyframes of a stream, used to know where to read from on seeking
+    filled from the index of the container (sidx/cues) and from the packets read during playback
+    not thread-safe
+*/
+class keyframe_index {
+  public:
+	struct Entry {
+		s64 timestamp; // in microseconds
+		s64 pos;       // byte position in the stream
+	};
+
+  private:
+	static constexpr s64 MIN_INTERVAL = 1000000; // keyframes closer than this to an indexed one are not indexed
+	static constexpr size_t MAX_ENTRIES = 16384;
+	std::vector<Entry> entries;
+
+  public:
+	size_t size() { return entries.size(); }
+	void clear() { entries.clear(); }
+	void add(s64 timestamp, s64 pos) {
+		if (pos < 0 || entries.size() >= MAX_ENTRIES) {
+			return;
+		}
+		auto next = std::upper_bound(entries.begin(), entries.end(), timestamp,
+		                             [](s64 timestamp, const Entry &entry) { return timestamp < entry.timestamp; });
+		if (next != entries.end() && next->timestamp - timestamp < MIN_INTERVAL) {
+			return;
+		}
+		if (next != entries.begin() && timestamp - std::prev(next)->timestamp < MIN_INTERVAL) {
+			return;
+		}
+		entries.insert(next, {timestamp, pos});
+	}
+	// finds the last indexed keyframe at or before `timestamp`, if it's at most `max_distance` before it
+	// (the part of the stream between the indexed keyframes may not have been read yet, so the last one can be far off)
+	bool find(s64 timestamp, s64 max_distance, Entry *res) {
+		auto next = std::upper_bound(entries.begin(), entries.end(), timestamp,
+		                             [](s64 timestamp, const Entry &entry) { return timestamp < entry.timestamp; });
+		if (next == entries.begin() || timestamp - std::prev(next)->timestamp > max_distance) {
+			return false;
+		}
+		*res = *std::prev(next);
+		return true;
+	}
+};
+
+inline void av_object_alloc(AVPacket **object) { *object = av_packet_alloc(); }
+inline void av_object_alloc(AVFrame **object) { *object = av_frame_alloc(); }
+inline void av_object_unref(AVPacket *object) { av_packet_unref(object); }
+inline void av_object_unref(AVFrame *object) { av_frame_unref(object); }
+inline void av_object_free(AVPacket **object) { av_packet_free(object); }
+inline void av_object_free(AVFrame **object) { av_frame_free(object); }
+/*
+    pool of AVPacket/AVFrame shells recycled instead of being allocated and freed for each packet or frame
+    (the data they reference is still unreferenced on release)
+    not thread-safe
+*/
+template <typename T> class av_object_pool {
+	std::vector<T *> free_objects;
+	size_t used_num = 0;
+	size_t high_water_mark = 0; // the maximum number of objects in use at the same time
+
+  public:
+	// returns NULL on allocation failure
+	T *acquire() {
+		T *res = NULL;
+		if (free_objects.size()) {
+			res = free_objects.back();
+			free_objects.pop_back();
+		} else {
+			av_object_alloc(&res);
+			if (!res) {
+				return NULL;
+			}
+		}
+		high_water_mark = std::max(high_water_mark, ++used_num);
+		return res;
+	}
+	void release(T *object) {
+		av_object_unref(object);
+		free_objects.push_back(object);
+		used_num--;
+	}
+	// objects still in use must have been released before this
+	void deinit() {
+		for (auto &i : free_objects) {
+			av_object_free(&i);
+		}
+		free_objects.clear();
+		used_num = 0;
+	}
+	size_t get_high_water_mark() { return high_water_mark; }
+};
 } // namespace network_decoder_
 
 class NetworkDecoder;
@@ -105,10 +266,28 @@ class NetworkDecoderFFmpegIOData {
 	int stream_index[2] = {0, 0};
 	NetworkDecoder *parent_decoder = NULL;
 	int packets_until_next_reinit = DECODER_REINIT_INTERVAL_PACKETS;
-
-	Result_with_string init_(int type, NetworkDecoder *parent_decoder);
-	Result_with_string init(NetworkStream *video_stream, NetworkStream *audio_stream, NetworkDecoder *parent_decoder);
-	Result_with_string init(NetworkStream *both_stream, NetworkDecoder *parent_decoder);
+	// keyframe_index[VIDEO/AUDIO] : index of the video/audio stream, kept across reinit_stream()
+	network_decoder_::keyframe_index keyframe_index[2];
+
+	// what was found by probing a stream, used to open another stream of the same kind (e.g. the next livestream
+	// fragment) without probing it again
+	struct ProbeInfo {
+		bool valid = false;
+		bool video_audio_separate = false;
+		const AVInputFormat *input_format[2] = {NULL, NULL};
+		std::vector<std::pair<AVMediaType, AVCodecID>> streams[2];
+	};
+	bool probe_skipped = false; // true if avformat_find_stream_info() was skipped thanks to `probed`
+
+	Result_with_string init_(int type, NetworkDecoder *parent_decoder, const ProbeInfo *probed);
+	// if `probed` is passed, its input format is reused and stream probing is skipped as long as the streams look the
+	// same
+	Result_with_string init(NetworkStream *video_stream, NetworkStream *audio_stream, NetworkDecoder *parent_decoder,
+	                        const ProbeInfo *probed = NULL);
+	Result_with_string init(NetworkStream *both_stream, NetworkDecoder *parent_decoder, const ProbeInfo *probed = NULL);
+	ProbeInfo get_probe_info();
+	// adds the keyframes in the index ffmpeg built from the container (e.g. the sidx box or the cues element)
+	void import_keyframe_index(int type);
 	void deinit_(int type, bool deinit_stream);
 	void deinit(bool deinit_stream);
 	Result_with_string reinit();
@@ -117,18 +296,31 @@ class NetworkDecoderFFmpegIOData {
 };
 
 class NetworkDecoderFilterData {
+  private:
+	// a rebuild of the graph drops the samples buffered in it, so they are not done more often than this
+	static constexpr double REBUILD_INTERVAL_MIN = 0.2;
+	// filters whose parameter can be changed without rebuilding the graph
+	std::vector<AVFilterContext *> tempo_filter_contexts;
+	AVFilterContext *volume_filter_context = NULL;
+	double last_rebuild_time = 0;
+
+	bool is_topology_changed(const AVCodecContext *audio_context);
+	void rebase_timestamp();
+
   public:
 	AVFilterGraph *audio_filter_graph = NULL;
 	AVFilterContext *audio_filter_src = NULL;
 	AVFilterContext *audio_filter_sink = NULL;
-	AVFrame *output_frame;
+	AVFrame *output_frame = NULL;
+	// true if all the filters are identity and the input is already in the output format : the graph is not built
+	bool bypass = false;
 
 	// actual values used
 	double volume = 1.0;
 	double tempo = 1.0;
 	double pitch = 1.0;
 	double equalizer_values[18] = {1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1};
-	// change requests(applied at reinitialization)
+	// change requests(applied by update() or at reinitialization)
 	volatile double volume_request = 1.0;
 	volatile double tempo_request = 1.0;
 	volatile double pitch_request = 1.0;
@@ -141,17 +333,36 @@ class NetworkDecoderFilterData {
 
 	void deinit();
 	Result_with_string init(AVCodecContext *audio_context);
+	// applies the change requests, through filter commands if possible and by rebuilding the graph otherwise
+	// *pending is set to true if the rebuild was postponed (it should be called again later)
+	Result_with_string update(AVCodecContext *audio_context, bool *pending);
 	Result_with_string
 	process_audio_frame(AVFrame *input, double *out_pts); // filtered frame goes to output_frame. It should NOT be freed
 };
 
 class NetworkDecoder {
+  public:
+	struct VideoOutputStats {
+		u64 frame_num = 0;        // frames converted by convert_decoded_video_frame()
+		u64 copied_frame_num = 0; // frames that had to be copied into a contiguous buffer before converting
+		u64 alloc_num = 0;        // allocations of the output buffers (should not grow during playback)
+	};
+	struct PacketQueueDepth {
+		size_t video;
+		size_t audio;
+	};
+	struct PoolStats {
+		size_t packet_high_water_mark; // the maximum number of packets buffered at the same time
+		size_t frame_high_water_mark;
+	};
+
   private:
 	static constexpr size_t OLD_MAX_RAW_BUFFER_SIZE = 3 * 1000 * 1000;
 	static constexpr size_t NEW_MAX_RAW_BUFFER_SIZE = 8 * 1000 * 1000;
 	static constexpr int VIDEO = 0;
 	static constexpr int AUDIO = 1;
 	static constexpr int BOTH = 0;
+	static constexpr s64 SEEK_KEYFRAME_DISTANCE_MAX = 3000000; // in microseconds, see seek()
 
 	// ffmpeg io/format related things
 	NetworkDecoderFFmpegIOData *io = NULL;
@@ -161,24 +372,66 @@ class NetworkDecoder {
 	const AVCodec *codec[2] = {NULL, NULL};
 
 	// buffers
-	std::deque<AVPacket *> packet_buffer[2];
+	network_decoder_::ring_queue<AVPacket *> packet_buffer[2];
+	network_decoder_::av_object_pool<AVPacket> packet_pool;
+	network_decoder_::av_object_pool<AVFrame> frame_pool;
 	network_decoder_::output_buffer<AVFrame *> video_tmp_frames;
 	network_decoder_::output_buffer<u8 *> video_mvd_tmp_frames;
 	u8 *mvd_frame = NULL; // internal buffer written directly by the mvd service
-	u8 *sw_video_output_tmp = NULL;
-	Mutex buffered_pts_list_lock;            // lock of buffered_pts_list
-	std::multiset<double> buffered_pts_list; // used for HW decoder to determine the pts when outputting a frame
+	u8 *sw_video_output_tmp = NULL; // used only when Y2R can't read the planes of a frame as they are
+	// the frame acquired by the last get_decoded_video_frame(), kept until convert_decoded_video_frame()
+	AVFrame *sw_video_output_frame = NULL;
+	// converted frames are written into a ring of buffers reused across frames
+	static constexpr int SW_VIDEO_OUTPUT_BUFFER_NUM = 2;
+	static constexpr size_t SW_VIDEO_OUTPUT_ALIGN = 0x80;
+	u8 *sw_video_output[SW_VIDEO_OUTPUT_BUFFER_NUM] = {NULL, NULL};
+	size_t sw_video_output_size = 0;
+	int sw_video_output_head = 0;
+	// used for HW decoder to determine the pts when outputting a frame (frames come out in presentation order)
+	// accessed only from the decoding thread, the pts is passed to the other thread with the frame in the output buffer
+	network_decoder_::pts_reorder_buffer<32> mvd_pending_pts;
 	bool mvd_first = false;
+	VideoOutputStats video_output_stats;
 
 	Mutex critical_op_lock; // lock between main(ui) thread and decoder thread
 
+	// demux stage : while the demux thread is running, it reads packets into packet_buffer ahead of the decoding with
+	// demux_packets(), otherwise packets are read on demand by the decoding thread
+	static constexpr size_t PACKET_QUEUE_MAX = 64;               // per stream type
+	static constexpr size_t PACKET_QUEUE_MAX_BYTES = 512 * 1024; // per stream type
+	static constexpr s64 PACKET_WAIT_TIMEOUT_NS = 100 * 1000 * 1000;
+	// a failed read of a stream that isn't finished (e.g. broken data) is retried after this many seconds
+	static constexpr double DEMUX_RETRY_INTERVAL = 1.0;
+	Mutex demux_lock;         // held while reading packets (see lock_demux())
+	Mutex packet_buffer_lock; // lock of packet_buffer, packet_buffer_bytes and packet_pool
+	size_t packet_buffer_bytes[2] = {0, 0};
+	Event packet_event; // signaled when the demux thread pushes a packet or fails to read
+	Event demux_event;  // signaled when packets are consumed
+	volatile bool demux_thread_running = false;
+	// the last read of the type (VIDEO, AUDIO or BOTH) failed, cleared by a seek or a change of the io data
+	volatile bool demux_failed[2] = {false, false};
+	double demux_failed_time[2] = {0, 0};
+	// the time base of the streams, cached so that the decoding thread doesn't touch the format context being demuxed
+	double stream_time_base[2] = {0, 0};
+
 	Result_with_string init_output_buffer(bool);
 	Result_with_string init_decoder(int type);
 	Result_with_string read_packet(int type);
+	// the stream of the type reached its end or can't be read any more (error or quit request)
+	bool is_stream_finished(int type);
 	Result_with_string mvd_decode(int *width, int *height);
 	AVStream *get_stream(int type) {
 		return io->format_context[is_av_separate() ? type : BOTH]->streams[io->stream_index[type]];
 	}
+	// the following functions are thread-safe against the demux thread
+	size_t get_packet_num(int type);
+	AVPacket *peek_packet(int type); // the packet stays valid until pop_packet(type)
+	void pop_packet(int type);
+	bool is_packet_queue_full(int type);
+	// reads packets of `type` if the queue is empty (does nothing if the demux thread is running)
+	void refill_packets(int type);
+
+	bool skip_non_ref_frames = false; // the state currently applied to decoder_context[VIDEO]
 
   public:
 	bool hw_decoder_enabled = false;
@@ -186,10 +439,16 @@ class NetworkDecoder {
 	volatile bool need_reinit = false;
 	volatile bool ready = false;
 	volatile bool avformat_reinit_request[2] = {false, false};
+	// set when the video is late : non-reference frames are not decoded and the loop filter is skipped
+	// (for the SW decoder only, applied on the next decode_video())
+	volatile bool skip_non_ref_frames_request = false;
 	double timestamp_offset = 0;
 	bool frame_cores_enabled[4];
 	bool slice_cores_enabled[4];
 
+	// sets `interrupt` and wakes up the decoder thread if it's waiting for the network
+	void request_interrupt();
+
 	bool is_audio_only() { return io->audio_only; }
 	bool is_av_separate() { return io->video_audio_separate; }
 
@@ -209,6 +468,22 @@ class NetworkDecoder {
 		return res;
 	}
 	std::vector<std::pair<double, std::vector<double>>> get_buffering_progress_bars(int bar_len);
+	// summed over the streams currently in use
+	NetworkStreamCacheStats get_cache_stats() {
+		NetworkStreamCacheStats res;
+		critical_op_lock.lock();
+		if (ready && io) {
+			for (int type = 0; type < 2; type++) {
+				if (io->network_stream[type]) {
+					res.hit_num += io->network_stream[type]->cache_stats.hit_num;
+					res.miss_num += io->network_stream[type]->cache_stats.miss_num;
+					res.evicted_num += io->network_stream[type]->cache_stats.evicted_num;
+				}
+			}
+		}
+		critical_op_lock.unlock();
+		return res;
+	}
 
 	size_t get_raw_buffer_num() { return hw_decoder_enabled ? video_mvd_tmp_frames.size() : video_tmp_frames.size(); }
 	size_t get_raw_buffer_num_max() {
@@ -223,12 +498,21 @@ class NetworkDecoder {
 	void deinit_filter() { filter.deinit(); }
 	// should be called after this->init()
 	Result_with_string init_filter() { return filter.init(decoder_context[AUDIO]); }
+	Result_with_string update_filter(bool *pending) { return filter.update(decoder_context[AUDIO], pending); }
 	// used for livestreams/premieres where the video is splitted into fragments
-	void change_ffmpeg_io_data(NetworkDecoderFFmpegIOData &ffmpeg_io_data, double timestamp_offset) {
-		interrupt = false;
-		this->io = &ffmpeg_io_data;
-		this->timestamp_offset = timestamp_offset;
-	}
+	// should be called with lock_demux() held while the demux thread is running
+	void change_ffmpeg_io_data(NetworkDecoderFFmpegIOData &ffmpeg_io_data, double timestamp_offset);
+
+	// demux stage
+	void set_demux_thread_running(bool running) { demux_thread_running = running; }
+	// reads packets until the queues are full, called repeatedly by the demux thread
+	// returns false if there was nothing to read, in which case the caller should wait with wait_for_demux_request()
+	bool demux_packets();
+	void wait_for_demux_request(s64 timeout_ns) { demux_event.wait(timeout_ns); }
+	// while locked, the demux thread doesn't read packets : must be held when seeking or changing the io data
+	void lock_demux() { demux_lock.lock(); }
+	void unlock_demux() { demux_lock.unlock(); }
+	PacketQueueDepth get_packet_queue_depth();
 
 	struct VideoFormatInfo {
 		int width;
@@ -287,14 +571,25 @@ class NetworkDecoder {
 	Result_with_string decode_video(int *width, int *height, bool *key_frame);
 
 	// decode the previously read audio packet
-	// if return.code == 0, *data is a malloced pointer and should be freed
-	// otherwise, *data is untouched
-	Result_with_string decode_audio(int *size, u8 **data, double *cur_pos);
+	// the output is written into the area returned by get_output_buffer(size in bytes), which is stored in *data
+	// if get_output_buffer() returns NULL, the frame is dropped and DEF_ERR_NEED_MORE_OUTPUT is returned
+	// otherwise if return.code != 0, *data is untouched
+	Result_with_string decode_audio(int *size, u8 **data, double *cur_pos,
+	                                const std::function<u8 *(int size)> &get_output_buffer);
 
 	// get the previously decoded video frame raw data
 	// the pointer stored in *data should NOT be freed
+	// for the software decoder, *data is set to NULL and the frame should be acquired via convert_decoded_video_frame()
 	Result_with_string get_decoded_video_frame(int width, int height, u8 **data, double *cur_pos);
 
+	// (software decoder only) converts the frame acquired by the last get_decoded_video_frame() into BGR565
+	// the pointer stored in *data should NOT be freed, and is valid until this function is called again
+	Result_with_string convert_decoded_video_frame(int width, int height, u8 **data);
+
+	VideoOutputStats get_video_output_stats() { return video_output_stats; }
+	PoolStats get_pool_stats() { return {packet_pool.get_high_water_mark(), frame_pool.get_high_water_mark()}; }
+
 	// seek both audio and video
+	// should be called with lock_demux() held while the demux thread is running
 	Result_with_string seek(s64 microseconds);
 };
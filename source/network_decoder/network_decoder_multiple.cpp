@@ -128,6 +128,8 @@ Result_with_string NetworkMultipleDecoder::init(std::string video_url, std::stri
 	if (result.code != 0) {
 		goto cleanup;
 	}
+	livestream_probe_info = tmp_ffmpeg_data.get_probe_info();
+	probe_skipped_num = 0;
 	fragments[fragment_id] = tmp_ffmpeg_data;
 	decoder.change_ffmpeg_io_data(fragments[fragment_id], adjust_timestamp ? fragment_id * fragment_len : 0);
 	result = decoder.init(request_hw_decoder);
@@ -176,8 +178,14 @@ Result_with_string NetworkMultipleDecoder::init(std::string both_url, NetworkStr
 void NetworkMultipleDecoder::check_filter_update() {
 	if (filter_update_request) {
 		filter_update_request = false;
-		decoder.deinit_filter();
-		decoder.init_filter();
+		bool pending;
+		Result_with_string result = decoder.update_filter(&pending);
+		if (pending) {
+			filter_update_request = true; // try again on the next audio frame
+		}
+		if (result.code != 0) {
+			logger.error("net/mul-dec", "filter update failed : " + result.error_description);
+		}
 	}
 }
 
@@ -203,8 +211,10 @@ NetworkMultipleDecoder::PacketType NetworkMultipleDecoder::next_decode_type() {
 		} else if (seq_using + 1 >= seq_num) {
 			res = PacketType::EoF;
 		} else {
+			decoder.lock_demux();
 			decoder.change_ffmpeg_io_data(fragments[seq_using + 1],
 			                              adjust_timestamp ? (seq_using + 1) * fragment_len : 0);
+			decoder.unlock_demux();
 			seq_using++;
 			res = decoder.next_decode_type();
 			// Util_log_save("net-mul", "after change ffmpeg res : " + std::to_string((int) res));
@@ -236,6 +246,15 @@ std::vector<std::pair<double, std::vector<double>>> NetworkMultipleDecoder::get_
 	}
 }
 Result_with_string NetworkMultipleDecoder::seek(s64 microseconds) {
+	decoder.lock_demux();
+	// the demux thread may have been waiting for the network in a read with the lock held, and only the interrupt makes
+	// it give up that read : clearing it before getting the lock could leave us waiting for the whole download
+	decoder.interrupt = false;
+	Result_with_string result = seek_(microseconds);
+	decoder.unlock_demux();
+	return result;
+}
+Result_with_string NetworkMultipleDecoder::seek_(s64 microseconds) {
 	Result_with_string result;
 	if (need_reinit) { // the initer function should be stopped
 		need_reinit = false;
@@ -321,7 +340,8 @@ void NetworkMultipleDecoder::livestream_initer_thread_func() {
 			downloader->add_stream(video_stream);
 			downloader->add_stream(audio_stream);
 
-			Result_with_string result = tmp_ffmpeg_data.init(video_stream, audio_stream, &decoder);
+			Result_with_string result =
+			    tmp_ffmpeg_data.init(video_stream, audio_stream, &decoder, &livestream_probe_info);
 			// Util_log_save("debug", "init finish");
 			if (result.code != 0) {
 				if (video_stream->livestream_eof || audio_stream->livestream_eof) {
@@ -359,7 +379,7 @@ void NetworkMultipleDecoder::livestream_initer_thread_func() {
 			    new NetworkStream(both_url + url_prefix, extract_stream_length(both_url), is_livestream, NULL);
 			both_stream->disable_interrupt = true;
 			downloader->add_stream(both_stream);
-			Result_with_string result = tmp_ffmpeg_data.init(both_stream, &decoder);
+			Result_with_string result = tmp_ffmpeg_data.init(both_stream, &decoder, &livestream_probe_info);
 			if (result.code == 0) {
 				if (both_stream->seq_head != -1) {
 					seq_head = both_stream->seq_head;
@@ -386,6 +406,12 @@ void NetworkMultipleDecoder::livestream_initer_thread_func() {
 			both_stream->disable_interrupt = false;
 		}
 
+		if (tmp_ffmpeg_data.probe_skipped) {
+			probe_skipped_num++;
+		} else {
+			livestream_probe_info = tmp_ffmpeg_data.get_probe_info();
+		}
+
 		fragments_lock.lock();
 		fragments[seq_next] = tmp_ffmpeg_data;
 		if (fragments.size() > MAX_CACHE_FRAGMENTS_NUM) {
@@ -400,11 +426,23 @@ void NetworkMultipleDecoder::livestream_initer_thread_func() {
 		recalc_buffered_head();
 		fragments_lock.unlock();
 
-		logger.info("net/live-init", "finish : " + std::to_string(seq_next));
+		std::string probe_status =
+		    tmp_ffmpeg_data.probe_skipped ? " (probe skipped, total " + std::to_string(probe_skipped_num) + ")" : "";
+		logger.info("net/live-init", "finish : " + std::to_string(seq_next) + probe_status);
 	}
 	initer_stopping = true;
 }
 
+void NetworkMultipleDecoder::demux_thread_func() {
+	decoder.set_demux_thread_running(true);
+	while (!initer_exit_request) {
+		if (!decoder.demux_packets()) {
+			decoder.wait_for_demux_request(DEMUX_WAIT_TIMEOUT_NS);
+		}
+	}
+	decoder.set_demux_thread_running(false);
+}
+
 void livestream_initer_thread_func(void *arg) {
 	NetworkMultipleDecoder *mul_decoder = (NetworkMultipleDecoder *)arg;
 	mul_decoder->livestream_initer_thread_func();
@@ -412,3 +450,10 @@ void livestream_initer_thread_func(void *arg) {
 	logger.info("net/live-init", "Thread exit.");
 	threadExit(0);
 }
+void demux_thread_func(void *arg) {
+	NetworkMultipleDecoder *mul_decoder = (NetworkMultipleDecoder *)arg;
+	mul_decoder->demux_thread_func();
+
+	logger.info("net/demux", "Thread exit.");
+	threadExit(0);
+}
@@ -32,6 +32,9 @@ class NetworkMultipleDecoder {
 	Mutex fragments_lock;
 	std::map<int, NetworkDecoderFFmpegIOData> fragments;
 	std::map<int, int> error_count;
+	// probing result of the last fragment, so that the following fragments don't have to be probed again
+	NetworkDecoderFFmpegIOData::ProbeInfo livestream_probe_info;
+	int probe_skipped_num = 0;
 	int fragment_len = -1;
 	NetworkStreamDownloader *downloader = NULL;
 
@@ -46,6 +49,9 @@ class NetworkMultipleDecoder {
 
 	void check_filter_update();
 	void recalc_buffered_head();
+	Result_with_string seek_(s64 microseconds);
+
+	static constexpr s64 DEMUX_WAIT_TIMEOUT_NS = 100 * 1000 * 1000;
 
   public:
 	volatile bool &hw_decoder_enabled = decoder.hw_decoder_enabled;
@@ -53,6 +59,8 @@ class NetworkMultipleDecoder {
 	volatile bool &need_reinit = decoder.need_reinit;
 	volatile const bool &ready = decoder.ready;
 
+	void request_interrupt() { decoder.request_interrupt(); }
+
 	volatile bool filter_update_request = false;
 	void set_preamp(double volume) {
 		decoder.filter.volume_request = volume;
@@ -72,6 +80,9 @@ class NetworkMultipleDecoder {
 	}
 	double get_tempo() { return decoder.filter.tempo; }
 
+	void set_skip_non_ref_frames(bool skip) { decoder.skip_non_ref_frames_request = skip; }
+	bool get_skip_non_ref_frames() { return decoder.skip_non_ref_frames_request; }
+
 	const char *get_network_waiting_status() { return decoder.get_network_waiting_status(); }
 
 	NetworkMultipleDecoder() = default;
@@ -84,6 +95,8 @@ class NetworkMultipleDecoder {
 	                        bool adjust_timestamp, bool request_hw_decoder);
 
 	void livestream_initer_thread_func();
+	// reads packets ahead of the decoding thread until request_thread_exit() is called
+	void demux_thread_func();
 	void request_thread_exit() { initer_exit_request = true; }
 
 	void set_frame_cores_enabled(bool *enabled) { decoder.set_frame_cores_enabled(enabled); }
@@ -123,6 +136,8 @@ class NetworkMultipleDecoder {
 	}
 
 	std::vector<std::pair<double, std::vector<double>>> get_buffering_progress_bars(int bar_len);
+	// for livestreams, only the fragment currently being played is counted
+	NetworkStreamCacheStats get_cache_stats() { return decoder.get_cache_stats(); }
 
 	// the switch to the next sequence is done inside this function
 	using PacketType = NetworkDecoder::PacketType;
@@ -139,9 +154,10 @@ class NetworkMultipleDecoder {
 	}
 
 	// decode the previously read audio packet
-	Result_with_string decode_audio(int *size, u8 **data, double *cur_pos) {
+	Result_with_string decode_audio(int *size, u8 **data, double *cur_pos,
+	                                const std::function<u8 *(int size)> &get_output_buffer) {
 		check_filter_update();
-		auto res = decoder.decode_audio(size, data, cur_pos);
+		auto res = decoder.decode_audio(size, data, cur_pos, get_output_buffer);
 		return res;
 	}
 
@@ -151,9 +167,16 @@ class NetworkMultipleDecoder {
 		auto res = decoder.get_decoded_video_frame(width, height, data, cur_pos);
 		return res;
 	}
+	Result_with_string convert_decoded_video_frame(int width, int height, u8 **data) {
+		return decoder.convert_decoded_video_frame(width, height, data);
+	}
+	NetworkDecoder::VideoOutputStats get_video_output_stats() { return decoder.get_video_output_stats(); }
+	NetworkDecoder::PacketQueueDepth get_packet_queue_depth() { return decoder.get_packet_queue_depth(); }
 
 	// seek both audio and video
+	// clears `interrupt` once the demux thread is stopped, an interrupt requested during the seek aborts it
 	Result_with_string seek(s64 microseconds);
 };
 // `arg` should be a pointer to an instance of NetworkMultipleDecoder
 void livestream_initer_thread_func(void *arg);
+void demux_thread_func(void *arg);
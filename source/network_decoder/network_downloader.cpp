@@ -9,6 +9,81 @@
 // NetworkStream implementation
 // --------------------------------
 
+NetworkStream::~NetworkStream() { free(block_arena); }
+
+// must be called with downloaded_data_lock locked
+bool NetworkStream::init_arena() {
+	if (block_arena) {
+		return true;
+	}
+	if (!block_num) {
+		return false; // the length of the stream is not known yet
+	}
+	size_t slot_num_max = std::min<u64>(block_num, MAX_CACHE_BLOCKS);
+	size_t slot_num_min = std::min<size_t>(slot_num_max, 2); // a single read may span two blocks
+	// halve the size on failure : retrying every 64 KiB step would mean hundreds of failing mallocs
+	for (slot_num = slot_num_max; slot_num > 0; slot_num = std::max(slot_num / 2, slot_num_min)) {
+		block_arena = (u8 *)malloc(slot_num * BLOCK_SIZE);
+		if (block_arena || slot_num == slot_num_min) {
+			break;
+		}
+	}
+	if (!block_arena) {
+		logger.error("net/dl", "block arena allocation failed");
+		slot_num = 0;
+		return false;
+	}
+	if (slot_num < slot_num_max) {
+		logger.warning("net/dl", "block arena shrunk : " + std::to_string(slot_num_max) + " -> " +
+		                             std::to_string(slot_num) + " blocks");
+	}
+	block_slot.assign(block_num, SLOT_NONE);
+	block_protected.assign(block_num, false);
+	protected_block_num = 0;
+	slot_block.assign(slot_num, -1);
+	free_slots.clear();
+	for (int slot = slot_num - 1; slot >= 0; slot--) {
+		free_slots.push_back(slot);
+	}
+	cached_block_num = 0;
+	return true;
+}
+
+int SeekAwareEvictionPolicy::pick_victim_slot(const NetworkStream &stream) {
+	u64 read_head_block = stream.read_head / NetworkStream::BLOCK_SIZE;
+	double forward_window = std::max(1.0, stream.slot_num * var_forward_buffer_ratio);
+	double backward_window = std::max(1.0, stream.slot_num - forward_window);
+
+	int victim = NetworkStream::SLOT_NONE;
+	int protected_victim = NetworkStream::SLOT_NONE;
+	double victim_score = -1;
+	double protected_victim_score = -1;
+	for (size_t slot = 0; slot < stream.slot_num; slot++) {
+		s64 block = stream.slot_block[slot];
+		if (block < 0 || stream.block_slot[block] != (int)slot) {
+			continue; // free or still being downloaded into
+		}
+		double score = (u64)block >= read_head_block ? (block - read_head_block) / forward_window
+		                                             : (read_head_block - block) / backward_window;
+		if (stream.block_protected[block]) {
+			if (score > protected_victim_score) {
+				protected_victim_score = score;
+				protected_victim = slot;
+			}
+		} else if (score > victim_score) {
+			victim_score = score;
+			victim = slot;
+		}
+	}
+	return victim != NetworkStream::SLOT_NONE ? victim : protected_victim;
+}
+SeekAwareEvictionPolicy NetworkStream::default_eviction_policy;
+// the constants bound to references (e.g. by std::min()) need a definition until C++17
+constexpr u64 NetworkStream::BLOCK_SIZE;
+constexpr u64 NetworkStream::NEW3DS_MAX_CACHE_BLOCKS;
+constexpr u64 NetworkStream::OLD3DS_MAX_CACHE_BLOCKS;
+constexpr int NetworkStream::SLOT_NONE;
+
 bool NetworkStream::is_data_available(u64 start, u64 size) {
 	if (!ready) {
 		return false;
@@ -23,7 +98,7 @@ bool NetworkStream::is_data_available(u64 start, u64 size) {
 	bool res = true;
 	downloaded_data_lock.lock();
 	for (u64 block = start_block; block <= end_block; block++) {
-		if (!downloaded_data.count(block)) {
+		if (block >= block_slot.size() || block_slot[block] == SLOT_NONE) {
 			res = false;
 			break;
 		}
@@ -31,77 +106,142 @@ bool NetworkStream::is_data_available(u64 start, u64 size) {
 	downloaded_data_lock.unlock();
 	return res;
 }
-std::vector<u8> NetworkStream::get_data(u64 start, u64 size) {
+bool NetworkStream::is_block_available(u64 block) {
+	downloaded_data_lock.lock();
+	bool res = block < block_slot.size() && block_slot[block] != SLOT_NONE;
+	downloaded_data_lock.unlock();
+	return res;
+}
+void NetworkStream::read_data(u64 start, u64 size, u8 *dst) {
 	if (!ready) {
-		return {};
+		return;
 	}
 	if (!size) {
-		return {};
+		return;
 	}
 	u64 end = start + size - 1;
 	u64 start_block = start / BLOCK_SIZE;
 	u64 end_block = end / BLOCK_SIZE;
-	std::vector<u8> res;
 
+	// the copy is done with the lock held so that the slots can't be recycled under our feet
 	downloaded_data_lock.lock();
-	auto itr = downloaded_data.find(start_block);
-	my_assert(itr != downloaded_data.end());
 	for (u64 block = start_block; block <= end_block; block++) {
-		my_assert(itr->first == block);
+		my_assert(block < block_slot.size() && block_slot[block] != SLOT_NONE);
+		if (protect_reads && !block_protected[block] && protected_block_num < slot_num * PROTECTED_SLOT_RATIO_MAX) {
+			block_protected[block] = true;
+			protected_block_num++;
+		}
 		u64 cur_l = std::max(start, block * BLOCK_SIZE) - block * BLOCK_SIZE;
 		u64 cur_r = std::min(end + 1, (block + 1) * BLOCK_SIZE) - block * BLOCK_SIZE;
-		res.insert(res.end(), itr->second.begin() + cur_l, itr->second.begin() + cur_r);
-		itr++;
+		memcpy(dst, block_arena + (size_t)block_slot[block] * BLOCK_SIZE + cur_l, cur_r - cur_l);
+		dst += cur_r - cur_l;
+	}
+	downloaded_data_lock.unlock();
+}
+u8 *NetworkStream::acquire_block_buffer(u64 block) {
+	u8 *res = NULL;
+	downloaded_data_lock.lock();
+	if (init_arena() && block < block_num) {
+		int slot = block_slot[block];
+		if (slot != SLOT_NONE) { // re-downloading an existing block : hide it until it's committed again
+			block_slot[block] = SLOT_NONE;
+			cached_block_num--;
+		} else if (free_slots.size()) {
+			slot = free_slots.back();
+			free_slots.pop_back();
+		} else { // ensure it doesn't cache too much and run out of memory
+			slot = eviction_policy->pick_victim_slot(*this);
+			if (slot != SLOT_NONE) {
+				block_slot[slot_block[slot]] = SLOT_NONE;
+				cached_block_num--;
+				cache_stats.evicted_num++;
+			}
+		}
+		if (slot != SLOT_NONE) {
+			slot_block[slot] = block;
+			res = block_arena + (size_t)slot * BLOCK_SIZE;
+		}
 	}
 	downloaded_data_lock.unlock();
 	return res;
 }
-void NetworkStream::set_data(u64 block, const std::vector<u8> &data) {
+void NetworkStream::commit_block(u64 block) {
 	downloaded_data_lock.lock();
-	downloaded_data[block] = data;
-	if (downloaded_data.size() > MAX_CACHE_BLOCKS) { // ensure it doesn't cache too much and run out of memory
-		u64 read_head_block = read_head / BLOCK_SIZE;
-		if (std::next(downloaded_data.begin())->first < read_head_block) {
-			downloaded_data.erase(std::next(downloaded_data.begin()));
-		} else {
-			downloaded_data.erase(std::prev(downloaded_data.end()));
+	for (size_t slot = 0; slot < slot_num; slot++) {
+		if (slot_block[slot] == (s64)block && block_slot[block] != (int)slot) {
+			block_slot[block] = slot;
+			cached_block_num++;
+			break;
+		}
+	}
+	downloaded_data_lock.unlock();
+	data_event.signal();
+}
+void NetworkStream::release_block_buffer(u64 block) {
+	downloaded_data_lock.lock();
+	for (size_t slot = 0; slot < slot_num; slot++) {
+		if (slot_block[slot] == (s64)block && block_slot[block] != (int)slot) {
+			slot_block[slot] = -1;
+			free_slots.push_back(slot);
+			break;
 		}
 	}
 	downloaded_data_lock.unlock();
 }
+void NetworkStream::set_data(u64 block, const u8 *data, size_t size) {
+	u8 *buffer = acquire_block_buffer(block);
+	if (!buffer) {
+		logger.error("net/dl", "no slot available for block #" + std::to_string(block));
+		error = true;
+		return;
+	}
+	memcpy(buffer, data, std::min<size_t>(size, BLOCK_SIZE));
+	commit_block(block);
+}
+void NetworkStream::set_read_head(u64 new_read_head) {
+	u64 old_read_head = read_head;
+	read_head = new_read_head;
+	if (downloader_event && old_read_head / BLOCK_SIZE != new_read_head / BLOCK_SIZE) {
+		downloader_event->signal();
+	}
+}
 double NetworkStream::get_download_percentage() {
 	downloaded_data_lock.lock();
-	double res = (double)downloaded_data.size() * BLOCK_SIZE / len * 100;
+	double res = (double)cached_block_num * BLOCK_SIZE / len * 100;
 	downloaded_data_lock.unlock();
 	return res;
 }
 std::vector<double> NetworkStream::get_buffering_progress_bar(int res_len) {
-	downloaded_data_lock.lock();
 	std::vector<double> res(res_len);
-	auto itr = downloaded_data.begin();
-	for (int i = 0; i < res_len; i++) {
-		u64 l = (u64)len * i / res_len;
-		u64 r = std::min<u64>(len, len * (i + 1) / res_len);
-		while (itr != downloaded_data.end()) {
-			u64 il = itr->first * BLOCK_SIZE;
-			u64 ir = std::min((itr->first + 1) * BLOCK_SIZE, len);
-			if (ir <= l) {
-				itr++;
-			} else if (il >= r) {
+	if (!len) {
+		return res;
+	}
+	downloaded_data_lock.lock();
+	for (size_t slot = 0; slot < slot_num; slot++) {
+		s64 block = slot_block[slot];
+		if (block < 0 || block_slot[block] != (int)slot) {
+			continue;
+		}
+		u64 il = block * BLOCK_SIZE;
+		u64 ir = std::min((block + 1) * BLOCK_SIZE, len);
+		for (int i = il * res_len / len; i < res_len; i++) {
+			u64 l = (u64)len * i / res_len;
+			u64 r = std::min<u64>(len, len * (i + 1) / res_len);
+			if (l >= ir) {
 				break;
-			} else {
+			}
+			if (r > il) {
 				res[i] += std::min(ir, r) - std::max(il, l);
-				if (ir >= r) {
-					break;
-				} else {
-					itr++;
-				}
 			}
 		}
+	}
+	downloaded_data_lock.unlock();
+	for (int i = 0; i < res_len; i++) {
+		u64 l = (u64)len * i / res_len;
+		u64 r = std::min<u64>(len, len * (i + 1) / res_len);
 		res[i] /= r - l;
 		res[i] *= 100;
 	}
-	downloaded_data_lock.unlock();
 	return res;
 }
 
@@ -110,6 +250,7 @@ std::vector<double> NetworkStream::get_buffering_progress_bar(int res_len) {
 // --------------------------------
 
 void NetworkStreamDownloader::add_stream(NetworkStream *stream) {
+	stream->downloader_event = &wakeup_event;
 	streams_lock.lock();
 	size_t index = (size_t)-1;
 	for (size_t i = 0; i < streams.size(); i++) {
@@ -124,6 +265,7 @@ void NetworkStreamDownloader::add_stream(NetworkStream *stream) {
 		streams.push_back(stream);
 	}
 	streams_lock.unlock();
+	wakeup_event.signal();
 }
 
 static bool thread_network_session_list_inited = false;
@@ -151,7 +293,188 @@ static std::string remove_url_parameter(const std::string &url, const std::strin
 	return res;
 }
 
+constexpr int NetworkStreamDownloader::PREFETCH_WINDOW_MAX;
+constexpr u64 NetworkStreamDownloader::RANGE_BLOCKS_MIN;
+constexpr u64 NetworkStreamDownloader::RANGE_BLOCKS_MAX;
+constexpr double NetworkStreamDownloader::LATENCY_MIN;
+
 #define LOG_THREAD_STR "net/dl"
+static double get_time_sec() { return (double)svcGetSystemTick() / SYSCLOCK_ARM11; }
+
+u64 NetworkStreamDownloader::get_range_block_num(const NetworkStream *stream) {
+	if (stream->bandwidth_estimate <= 0) {
+		return RANGE_BLOCKS_DEFAULT;
+	}
+	double target_size =
+	    stream->bandwidth_estimate * std::max(LATENCY_MIN, stream->latency_estimate) * RANGE_LATENCY_RATIO;
+	return std::max(RANGE_BLOCKS_MIN, std::min(RANGE_BLOCKS_MAX, (u64)std::ceil(target_size / BLOCK_SIZE)));
+}
+
+void NetworkStreamDownloader::download_blocks(NetworkStream *stream, u64 read_head, u64 forward_buffer_block_num) {
+	u64 read_head_block = read_head / BLOCK_SIZE;
+	u64 block_end = std::min<u64>(stream->block_num, read_head_block + forward_buffer_block_num);
+	int window = std::max(1, std::min(PREFETCH_WINDOW_MAX, var_prefetch_window));
+	u64 range_block_num = get_range_block_num(stream);
+	// the reader is waiting (e.g. right after a seek) : request the block under the read head alone so that it
+	// arrives as early as possible
+	bool stalled = !stream->is_block_available(read_head_block);
+
+	struct Range {
+		u64 first_block;
+		std::vector<u8 *> buffers;
+		u64 size;
+		u64 received = 0;
+		size_t committed_num = 0;
+		double first_byte_time = -1;
+		double finish_time = -1;
+	};
+	// reserve arena slots for runs of missing blocks past the read head
+	std::vector<Range> ranges;
+	bool arena_full = false;
+	u64 block = read_head_block;
+	while (block < block_end && (int)ranges.size() < window && !arena_full) {
+		if (stream->is_block_available(block)) {
+			block++;
+			continue;
+		}
+		u64 cur_range_block_num = stalled && !ranges.size() ? RANGE_BLOCKS_MIN : range_block_num;
+		Range range;
+		range.first_block = block;
+		while (block < block_end && range.buffers.size() < cur_range_block_num && !stream->is_block_available(block)) {
+			u8 *buffer = stream->acquire_block_buffer(block);
+			if (!buffer) {
+				arena_full = true;
+				break;
+			}
+			range.buffers.push_back(buffer);
+			block++;
+		}
+		if (range.buffers.size()) {
+			range.size = std::min(block * BLOCK_SIZE, stream->len) - range.first_block * BLOCK_SIZE;
+			ranges.push_back(range);
+		}
+	}
+	if (!ranges.size()) {
+		if (arena_full) {
+			logger.error(LOG_THREAD_STR, "failed to acquire a block buffer");
+			stream->error = true;
+		}
+		return; // otherwise the read head moved while we were looking for blocks to download
+	}
+
+	// the requests are multiplexed over the same connection, and each block is committed as soon as its last byte
+	// arrives so that the reader can resume without waiting for the whole range (or the whole batch)
+	std::vector<HttpRequest> requests;
+	for (auto &range : ranges) {
+		u64 start = range.first_block * BLOCK_SIZE;
+		Range *cur_range = &range;
+		requests.push_back(
+		    HttpRequest::GET(stream->url + "&range=" + std::to_string(start) + "-" +
+		                         std::to_string(start + range.size - 1),
+		                     {})
+		        .with_data_callback([stream, cur_range](const u8 *data, size_t size) {
+			        if (cur_range->first_byte_time < 0) {
+				        cur_range->first_byte_time = get_time_sec();
+			        }
+			        if (cur_range->received + size > cur_range->size) {
+				        return false;
+			        }
+			        while (size) {
+				        size_t index = cur_range->received / BLOCK_SIZE;
+				        size_t offset = cur_range->received % BLOCK_SIZE;
+				        size_t cur_size = std::min<size_t>(size, BLOCK_SIZE - offset);
+				        memcpy(cur_range->buffers[index] + offset, data, cur_size);
+				        data += cur_size;
+				        size -= cur_size;
+				        cur_range->received += cur_size;
+				        if (offset + cur_size == BLOCK_SIZE || cur_range->received == cur_range->size) {
+					        stream->commit_block(cur_range->first_block + index);
+					        cur_range->committed_num++;
+				        }
+			        }
+			        return true;
+		        })
+		        .with_on_finish_callback([cur_range](NetworkResult &, int) { cur_range->finish_time = get_time_sec(); }));
+	}
+
+	auto &session_list = stream->session_list ? *stream->session_list : thread_network_session_list;
+	double start_time = get_time_sec();
+	auto results = session_list.perform(requests);
+
+	bool retry = false;
+	u64 received_total = 0;
+	double first_byte_time = -1;
+	double finish_time = -1;
+	double latency = -1;
+	for (size_t i = 0; i < ranges.size(); i++) {
+		auto &range = ranges[i];
+		auto &result = results[i];
+		if (result.redirected_url != "") {
+			stream->url = remove_url_parameter(result.redirected_url, "range");
+		}
+		if (range.first_byte_time >= 0) {
+			received_total += range.received;
+			if (first_byte_time < 0 || first_byte_time > range.first_byte_time) {
+				first_byte_time = range.first_byte_time;
+			}
+			finish_time = std::max(finish_time, range.finish_time);
+			if (latency < 0 || latency > range.first_byte_time - start_time) {
+				latency = range.first_byte_time - start_time;
+			}
+		}
+		if (range.committed_num == range.buffers.size()) {
+			continue;
+		}
+		// the blocks that have been completely received are kept
+		for (size_t j = range.committed_num; j < range.buffers.size(); j++) {
+			stream->release_block_buffer(range.first_block + j);
+		}
+		if (!result.fail && result.status_code_is_success()) {
+			logger.error(LOG_THREAD_STR, "size discrepancy : " + std::to_string(range.size) + " -> " +
+			                                 std::to_string(range.received));
+			retry = true;
+		} else if (!result.fail) {
+			logger.error("net/dl", "stream returned: " + std::to_string(result.status_code));
+			stream->error = true;
+		} else {
+			logger.error("net/dl", "access failed : " + result.error);
+			retry = true;
+		}
+	}
+	if (retry) {
+		if (stream->retry_cnt_left) {
+			stream->retry_cnt_left--;
+		} else {
+			stream->error = true;
+		}
+	} else {
+		stream->retry_cnt_left = NetworkStream::RETRY_CNT_MAX;
+	}
+
+	downloaded_bytes += received_total;
+
+	// update the link estimates used to size the next ranges
+	if (latency >= 0) {
+		stream->latency_estimate = stream->latency_estimate > 0 ? stream->latency_estimate * (1 - ESTIMATE_SMOOTHING) +
+		                                                              latency * ESTIMATE_SMOOTHING
+		                                                        : latency;
+	}
+	if (received_total && finish_time > first_byte_time) {
+		double bandwidth = received_total / (finish_time - first_byte_time);
+		stream->bandwidth_estimate = stream->bandwidth_estimate > 0
+		                                 ? stream->bandwidth_estimate * (1 - ESTIMATE_SMOOTHING) +
+		                                       bandwidth * ESTIMATE_SMOOTHING
+		                                 : bandwidth;
+	}
+}
+
+// the number of blocks to keep downloaded ahead of the read head, a share of the slots of the stream
+static u64 get_forward_buffer_block_num(const NetworkStream *stream) {
+	// the arena is allocated when the first block lands and may be smaller than requested, assume the full size before
+	u64 slot_num = stream->slot_num ? stream->slot_num : std::min<u64>(stream->block_num, MAX_CACHE_BLOCKS);
+	return std::max<u64>(2, (std::max<u64>(slot_num, 1) - 1) * var_forward_buffer_ratio); // block #0 is always kept
+}
+
 void NetworkStreamDownloader::downloader_thread() {
 	while (!thread_exit_requested) {
 		size_t cur_stream_index =
@@ -190,12 +513,11 @@ void NetworkStreamDownloader::downloader_thread() {
 				continue; // its entire content should already be downloaded
 			}
 
-			int forward_buffer_block_num =
-			    std::max<int>(2, (MAX_CACHE_BLOCKS - 1) * var_forward_buffer_ratio); // block #0 is always kept
+			u64 forward_buffer_block_num = get_forward_buffer_block_num(streams[i]);
 			u64 read_head_block = read_heads[i] / BLOCK_SIZE;
 			u64 first_not_downloaded_block = read_head_block;
 			while (first_not_downloaded_block < streams[i]->block_num &&
-			       streams[i]->downloaded_data.count(first_not_downloaded_block)) {
+			       streams[i]->is_block_available(first_not_downloaded_block)) {
 				first_not_downloaded_block++;
 				if (first_not_downloaded_block == read_head_block + forward_buffer_block_num) {
 					break;
@@ -223,7 +545,8 @@ void NetworkStreamDownloader::downloader_thread() {
 
 		if (cur_stream_index == (size_t)-1) {
 			streams_lock.unlock();
-			usleep(20000);
+			// sleep until a stream is added or a read head moves
+			wakeup_event.wait(IDLE_WAIT_TIMEOUT_NS);
 			continue;
 		}
 		NetworkStream *cur_stream = streams[cur_stream_index];
@@ -262,8 +585,7 @@ void NetworkStreamDownloader::downloader_thread() {
 					for (size_t i = 0; i < result.data.size(); i += BLOCK_SIZE) {
 						size_t left = i;
 						size_t right = std::min<size_t>(i + BLOCK_SIZE, result.data.size());
-						cur_stream->set_data(i / BLOCK_SIZE,
-						                     std::vector<u8>(result.data.begin() + left, result.data.begin() + right));
+						cur_stream->set_data(i / BLOCK_SIZE, &result.data[left], right - left);
 					}
 					cur_stream->ready = true;
 				}
@@ -282,25 +604,13 @@ void NetworkStreamDownloader::downloader_thread() {
 					break;
 				}
 			}
+		} else if (cur_stream->ready) {
+			download_blocks(cur_stream, read_heads[cur_stream_index], get_forward_buffer_block_num(cur_stream));
 		} else {
+			// the first block is fetched alone as the length of the stream may not be known yet
 			u64 block_reading = read_heads[cur_stream_index] / BLOCK_SIZE;
-			if (cur_stream->ready) {
-				while (block_reading < cur_stream->block_num && cur_stream->downloaded_data.count(block_reading)) {
-					block_reading++;
-				}
-				if (block_reading == cur_stream->block_num) { // something unexpected happened
-					logger.error(LOG_THREAD_STR, "unexpected error (trying to read beyond the end of the stream)");
-					cur_stream->error = true;
-					continue;
-				}
-			}
-			// Util_log_save("net/dl", "dl next : " + std::to_string(cur_stream_index) + " " +
-			// std::to_string(block_reading));
-
 			u64 start = block_reading * BLOCK_SIZE;
-			u64 end = cur_stream->ready ? std::min((block_reading + 1) * BLOCK_SIZE, cur_stream->len)
-			                            : (block_reading + 1) * BLOCK_SIZE;
-			u64 expected_len = end - start;
+			u64 end = (block_reading + 1) * BLOCK_SIZE;
 
 			auto &session_list = cur_stream->session_list ? *cur_stream->session_list : thread_network_session_list;
 			// length not sure -> use Range header to get the size (slower)
@@ -337,18 +647,8 @@ void NetworkStreamDownloader::downloader_thread() {
 						cur_stream->error = true;
 					}
 				}
-				if (cur_stream->ready && result.data.size() != expected_len) {
-					logger.error(LOG_THREAD_STR, "size discrepancy : " + std::to_string(expected_len) + " -> " +
-					                                 std::to_string(result.data.size()));
-					if (cur_stream->retry_cnt_left) {
-						cur_stream->retry_cnt_left--;
-					} else {
-						cur_stream->error = true;
-					}
-					continue;
-				}
 				cur_stream->retry_cnt_left = NetworkStream::RETRY_CNT_MAX;
-				cur_stream->set_data(block_reading, result.data);
+				cur_stream->set_data(block_reading, result.data.data(), result.data.size());
 				cur_stream->ready = true;
 			} else if (!result.fail) {
 				logger.error("net/dl", "stream returned: " + std::to_string(result.status_code));
@@ -362,11 +662,14 @@ void NetworkStreamDownloader::downloader_thread() {
 				}
 			}
 		}
+		// let the reader re-check `ready` and `error`
+		cur_stream->data_event.signal();
 	}
 	logger.info(LOG_THREAD_STR, "Exit, deiniting...");
 	for (auto stream : streams) {
 		if (stream) {
 			stream->quit_request = true;
+			stream->data_event.signal();
 		}
 	}
 }
@@ -6,21 +6,66 @@
 #include "system/libctru_wrapper.hpp"
 #include "network_io.hpp"
 
+struct NetworkStream;
+
+struct NetworkStreamCacheStats {
+	u64 hit_num = 0;     // reads served straight from the cache
+	u64 miss_num = 0;    // reads that had to wait for the network
+	u64 evicted_num = 0; // blocks dropped to make room for other blocks
+};
+
+// decides which cached block of a stream is dropped when its arena is full
+class NetworkStreamEvictionPolicy {
+  public:
+	virtual ~NetworkStreamEvictionPolicy() = default;
+	// called with stream.downloaded_data_lock locked, returns the slot to evict (or NetworkStream::SLOT_NONE)
+	// only committed slots (slot_block[slot] >= 0 && block_slot[slot_block[slot]] == slot) may be returned
+	virtual int pick_victim_slot(const NetworkStream &stream) = 0;
+};
+
+// drops the block that is the farthest from the read head, where the distance ahead of the read head is measured
+// relative to the forward buffer and the distance behind it relative to the rest of the cache, so that the region
+// around the read head survives a short backward seek
+// blocks holding the container header/index are only dropped when nothing else is left
+class SeekAwareEvictionPolicy : public NetworkStreamEvictionPolicy {
+  public:
+	int pick_victim_slot(const NetworkStream &stream) override;
+};
+
 // one instance per one url (once constructed, the url is not changeable)
 struct NetworkStream {
-	static constexpr u64 BLOCK_SIZE = 0x40000; // 256 KiB
-	static constexpr u64 NEW3DS_MAX_CACHE_BLOCKS = 12 * 1000 * 1000 / BLOCK_SIZE;
-	static constexpr u64 OLD3DS_MAX_CACHE_BLOCKS = 4 * 1000 * 1000 / BLOCK_SIZE;
+	// the unit of caching : a single range request covers one or more consecutive blocks
+	static constexpr u64 BLOCK_SIZE = 0x10000; // 64 KiB
+	static constexpr u64 NEW3DS_MAX_CACHE_SIZE = 12 * 1000 * 1000;
+	static constexpr u64 OLD3DS_MAX_CACHE_SIZE = 4 * 1000 * 1000;
+	static constexpr u64 NEW3DS_MAX_CACHE_BLOCKS = NEW3DS_MAX_CACHE_SIZE / BLOCK_SIZE;
+	static constexpr u64 OLD3DS_MAX_CACHE_BLOCKS = OLD3DS_MAX_CACHE_SIZE / BLOCK_SIZE;
 	static constexpr int RETRY_CNT_MAX = 1;
+	static constexpr int SLOT_NONE = -1;
 	static u64 get_block_num(u64 size) { return (size + BLOCK_SIZE - 1) / BLOCK_SIZE; }
 
 	std::string url;
-	Mutex downloaded_data_lock; // std::map needs locking when searching and inserting at the same time
+	Mutex downloaded_data_lock; // the block index needs locking when searching and inserting at the same time
 	u64 len = 0;
 	u64 block_num = 0;
-	std::map<u64, std::vector<u8>> downloaded_data;
+	// downloaded blocks live in a single preallocated arena of `slot_num` slots of BLOCK_SIZE bytes each
+	// block_slot[block] is the slot holding the block (or SLOT_NONE), slot_block[slot] is the block in the slot
+	u8 *block_arena = NULL;
+	size_t slot_num = 0;
+	std::vector<int> block_slot;
+	std::vector<s64> slot_block; // -1 : free, otherwise the block the slot is assigned to (maybe still downloading)
+	std::vector<int> free_slots;
+	size_t cached_block_num = 0;
+	// blocks read while `protect_reads` is set (the container header and index) are kept preferentially
+	std::vector<bool> block_protected;
+	size_t protected_block_num = 0;
+	NetworkStreamEvictionPolicy *eviction_policy = &default_eviction_policy;
+	NetworkStreamCacheStats cache_stats; // hits and misses are counted by the reader (network_decoder.cpp)
 	bool whole_download = false;
 	NetworkSessionList *session_list = NULL;
+	// measured by the downloader and used to size the range requests (0 : not measured yet)
+	double bandwidth_estimate = 0; // bytes per second
+	double latency_estimate = 0;   // seconds until the first byte of a response arrives
 
 	// anything above here is not supposed to be used from outside network_downloader.cpp and network_downloader.hpp
 	volatile bool ready = false;
@@ -29,6 +74,9 @@ struct NetworkStream {
 	volatile bool error = false;
 	volatile int retry_cnt_left = RETRY_CNT_MAX;
 	volatile u64 read_head = 0;
+	volatile bool protect_reads = false;
+	Event data_event; // signaled when a block lands or the state of the stream changes (e.g. error)
+	Event *downloader_event = NULL; // set by NetworkStreamDownloader::add_stream()
 	const char *volatile network_waiting_status = NULL;
 	bool disable_interrupt = false;
 	// used for livestreams
@@ -43,19 +91,43 @@ struct NetworkStream {
 	NetworkStream(std::string url, int64_t len, bool whole_download, NetworkSessionList *session_list)
 	    : url(url), len(len < 0 ? 0 : len), block_num(get_block_num(this->len)), whole_download(whole_download),
 	      session_list(session_list) {}
+	~NetworkStream();
+	// the arena is referenced by raw pointers, so it must never be copied
+	NetworkStream(const NetworkStream &) = delete;
+	NetworkStream &operator=(const NetworkStream &) = delete;
 
 	double get_download_percentage();
 	std::vector<double> get_buffering_progress_bar(int res_len);
 
+	// moves the read head and wakes up the downloader if it moved to another block
+	void set_read_head(u64 new_read_head);
+	// blocks until the downloader reports an update on this stream or the timeout expires
+	void wait_for_update(s64 timeout_ns) { data_event.wait(timeout_ns); }
+
 	// check if the data of the current stream of range [start, start + size) is already downloaded and available
 	bool is_data_available(u64 start, u64 size);
+	bool is_block_available(u64 block);
 
 	// this function must only be called when is_data_available(start, size) returns true
-	// returns the data of the stream of range [start, start + size)
-	std::vector<u8> get_data(u64 start, u64 size);
+	// copies the data of the stream of range [start, start + size) straight from the arena into `dst`
+	void read_data(u64 start, u64 size, u8 *dst);
+
+	// the following functions are supposed to be called from NetworkStreamDownloader::*
+	// reserves a slot for `block` (evicting another block if the arena is full) and returns its memory, which can be
+	// written into without holding the lock. Returns NULL if the arena could not be allocated
+	u8 *acquire_block_buffer(u64 block);
+	// makes the block reserved by acquire_block_buffer() visible to readers
+	void commit_block(u64 block);
+	// gives back the slot reserved by acquire_block_buffer() without publishing it (e.g. the download failed)
+	void release_block_buffer(u64 block);
+	void set_data(u64 block, const u8 *data, size_t size);
+
+  private:
+	static SeekAwareEvictionPolicy default_eviction_policy;
+	// at most this proportion of the arena is spent on protected blocks
+	static constexpr double PROTECTED_SLOT_RATIO_MAX = 0.25;
 
-	// this function is supposed to be called from NetworkStreamDownloader::*
-	void set_data(u64 block, const std::vector<u8> &data);
+	bool init_arena();
 };
 
 // each instance of this class is paired with one downloader thread
@@ -64,22 +136,47 @@ struct NetworkStream {
 class NetworkStreamDownloader {
   private:
 	static constexpr u64 BLOCK_SIZE = NetworkStream::BLOCK_SIZE;
+	// the thread is woken up by events, this is only a safety net for state changes nobody signals (e.g. quit_request)
+	static constexpr s64 IDLE_WAIT_TIMEOUT_NS = 100 * 1000 * 1000;
 	static constexpr const char *USER_AGENT = "Mozilla/5.0 (Linux; Android 11; Pixel 3a) AppleWebKit/537.36 (KHTML, "
 	                                          "like Gecko) Chrome/83.0.4103.101 Mobile Safari/537.36";
 
+	// maximum number of concurrent range requests per stream (the actual number is var_prefetch_window)
+	static constexpr int PREFETCH_WINDOW_MAX = 4;
+	// the size of a range request (in blocks) is chosen so that it takes about RANGE_LATENCY_RATIO round trips
+	// to transfer, which keeps the per-request overhead low on slow links without delaying the first frame on seeks
+	static constexpr u64 RANGE_BLOCKS_MIN = 1;     // 64 KiB, used for the block under a stalled read head
+	static constexpr u64 RANGE_BLOCKS_DEFAULT = 4; // 256 KiB, used until the link has been measured
+	static constexpr u64 RANGE_BLOCKS_MAX = 16;    // 1 MiB
+	static constexpr double RANGE_LATENCY_RATIO = 4;
+	static constexpr double LATENCY_MIN = 0.02;
+	static constexpr double ESTIMATE_SMOOTHING = 0.3; // weight of a new sample in the moving averages
+
 	Mutex streams_lock;
 	std::vector<NetworkStream *> streams;
 
 	bool thread_exit_requested = false;
+	Event wakeup_event;
+	volatile u64 downloaded_bytes = 0; // total over all streams, for statistics
+
+	// fetches the next missing blocks of a ready stream past `read_head` with concurrent range requests
+	void download_blocks(NetworkStream *stream, u64 read_head, u64 forward_buffer_block_num);
 
   public:
 	NetworkStreamDownloader() = default;
 
+	// the number of blocks requested at once for the stream, from its measured bandwidth and latency
+	static u64 get_range_block_num(const NetworkStream *stream);
+
 	// the pointer must be one that has been new-ed : it will be deleted once quit_request is made
 	void add_stream(NetworkStream *stream);
 
-	void request_thread_exit() { thread_exit_requested = true; }
+	void request_thread_exit() {
+		thread_exit_requested = true;
+		wakeup_event.signal();
+	}
 	void delete_all();
+	u64 get_downloaded_bytes() { return downloaded_bytes; }
 
 	void downloader_thread();
 };
@@ -46,14 +46,31 @@ static std::string remove_leading_whitespaces(std::string str) {
 
 // libcurl callback functions
 static size_t curl_receive_data_callback_func(char *in_ptr, size_t, size_t len, void *user_data) {
-	std::vector<u8> *out = (std::vector<u8> *)user_data;
-	out->insert(out->end(), in_ptr, in_ptr + len);
+	NetworkResult *res = (NetworkResult *)user_data;
+	// only the body of the final successful response goes to the data callback (not error pages or redirections)
+	if (res->data_callback && res->status_code_is_success()) {
+		if (!(*res->data_callback)((const u8 *)in_ptr, len)) {
+			return 0; // makes curl abort the transfer with CURLE_WRITE_ERROR
+		}
+	} else {
+		// keep room for a terminating '\0' so that the body can be parsed in-situ without being reallocated
+		size_t required = res->data.size() + len + 1;
+		if (res->data.capacity() < required) {
+			size_t content_length = 0;
+			if (res->data.empty() && !res->response_headers.count("content-encoding")) {
+				content_length = strtoul(res->get_header("content-length").c_str(), NULL, 10);
+			}
+			res->data.reserve(std::max({required, res->data.capacity() * 2, content_length + 1}));
+		}
+		res->data.insert(res->data.end(), in_ptr, in_ptr + len);
+	}
 
 	// Util_log_save("curl", "received : " + std::to_string(len));
 	return len;
 }
 static size_t curl_receive_headers_callback_func(char *in_ptr, size_t, size_t len, void *user_data) {
-	std::map<std::string, std::string> *out = (std::map<std::string, std::string> *)user_data;
+	NetworkResult *res = (NetworkResult *)user_data;
+	std::map<std::string, std::string> *out = &res->response_headers;
 
 	std::string cur_line = std::string(in_ptr, in_ptr + len);
 	if (cur_line.size() && cur_line.back() == '\n') {
@@ -62,6 +79,14 @@ static size_t curl_receive_headers_callback_func(char *in_ptr, size_t, size_t le
 	if (cur_line.size() && cur_line.back() == '\r') {
 		cur_line.pop_back();
 	}
+	if (cur_line.substr(0, 5) == "HTTP/") {
+		// status line of a (possibly intermediate) response, the final value is set again once the request completes
+		size_t space = cur_line.find(' ');
+		if (space != std::string::npos) {
+			res->status_code = atoi(cur_line.c_str() + space + 1);
+		}
+		return len;
+	}
 	auto colon = std::find(cur_line.begin(), cur_line.end(), ':');
 	if (colon == cur_line.end()) {
 		// Util_log_save("curl", "unknown header line : " + cur_line);
@@ -140,8 +165,9 @@ void NetworkSessionList::curl_add_request(const HttpRequest &request, NetworkRes
 	curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
 	// curl_easy_setopt(curl, CURLOPT_TIMEOUT, timeout);
 
-	curl_easy_setopt(curl, CURLOPT_WRITEDATA, &res->data);
-	curl_easy_setopt(curl, CURLOPT_HEADERDATA, &res->response_headers);
+	res->data_callback = request.on_data ? &request.on_data : NULL;
+	curl_easy_setopt(curl, CURLOPT_WRITEDATA, res);
+	curl_easy_setopt(curl, CURLOPT_HEADERDATA, res);
 	curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, request.method.c_str());
 	curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, (long)request.follow_redirect);
 	curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request.body.c_str());
@@ -197,6 +223,7 @@ CURLMcode NetworkSessionList::curl_perform_requests() {
 					             std::string("deep fail : ") + curl_easy_strerror(each_result) + " / " + req.errbuf);
 					res.fail = true;
 					res.error = req.errbuf;
+					res.status_code = -1;
 				}
 				if (req.on_finish) {
 					req.on_finish(res, request_index);
@@ -234,6 +261,7 @@ CURLMcode NetworkSessionList::curl_perform_requests() {
 }
 void NetworkSessionList::curl_clear_requests() {
 	for (auto &i : curl_requests) {
+		i.res->data_callback = NULL; // it points into the request, which may not outlive the result
 		free(i.errbuf);
 		curl_multi_remove_handle(curl_multi, i.curl);
 		curl_easy_cleanup(i.curl);
@@ -259,7 +287,7 @@ std::vector<NetworkResult> NetworkSessionList::perform(const std::vector<HttpReq
 	std::vector<NetworkResult> results(requests.size());
 
 	if (!this->inited) {
-		for (auto result : results) {
+		for (auto &result : results) {
 			result.fail = true;
 			result.error = "invalid session list";
 		}
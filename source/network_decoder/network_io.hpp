@@ -15,6 +15,8 @@ struct NetworkResult {
 	std::string status_message;
 	std::vector<u8> data;
 	std::map<std::string, std::string> response_headers;
+	// if the request has a data callback, the body is passed to it instead of being stored in `data`
+	const std::function<bool(const u8 *, size_t)> *data_callback = NULL;
 
 	bool status_code_is_success() { return status_code / 100 == 2; }
 	std::string get_header(std::string key);
@@ -30,6 +32,10 @@ struct HttpRequest { // including https
 	progress_callback_t progress_func{};
 	using on_finish_callback_t = std::function<void(NetworkResult &, int)>;
 	on_finish_callback_t on_finish{};
+	// if set, the response body is passed to this function chunk by chunk as it arrives instead of being stored in
+	// NetworkResult::data. Returning false aborts the transfer
+	using data_callback_t = std::function<bool(const u8 *, size_t)>;
+	data_callback_t on_data{};
 
 	static std::map<std::string, std::string> default_headers_added(std::map<std::string, std::string> headers) {
 		// Set up default Android/YouTube client headers
@@ -59,11 +65,21 @@ struct HttpRequest { // including https
 	}
 
 	HttpRequest with_progress_func(progress_callback_t progress_func) const {
-		return HttpRequest{method, url, headers, body, follow_redirect, progress_func, on_finish};
+		HttpRequest res = *this;
+		res.progress_func = progress_func;
+		return res;
 	}
 
 	HttpRequest with_on_finish_callback(on_finish_callback_t on_finish) const {
-		return HttpRequest{method, url, headers, body, follow_redirect, progress_func, on_finish};
+		HttpRequest res = *this;
+		res.on_finish = on_finish;
+		return res;
+	}
+
+	HttpRequest with_data_callback(data_callback_t on_data) const {
+		HttpRequest res = *this;
+		res.on_data = on_data;
+		return res;
 	}
 };
 
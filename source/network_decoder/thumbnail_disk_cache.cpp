@@ -0,0 +1,271 @@
+#include "headers.hpp"
+#include "thumbnail_disk_cache.hpp"
+#include <unordered_map>
+
+#define THUMBNAIL_CACHE_DIR (DEF_MAIN_DIR + "thumbnail_cache/")
+#define BLOB_FILE_PATH (THUMBNAIL_CACHE_DIR + "blob.bin")
+#define BLOB_FILE_TMP_PATH (THUMBNAIL_CACHE_DIR + "blob_tmp.bin")
+#define INDEX_FILE_PATH (THUMBNAIL_CACHE_DIR + "index.bin")
+#define INDEX_FILE_TMP_PATH (THUMBNAIL_CACHE_DIR + "index_tmp.bin")
+
+#define INDEX_MAGIC 0x43485446 // "FTHC"
+#define INDEX_VERSION 0
+
+#define BLOB_SIZE_MAX (8 * 1000 * 1000)
+#define BLOB_SIZE_AFTER_COMPACTION (BLOB_SIZE_MAX / 2)
+#define ENTRY_SIZE_MAX (256 * 1000)
+#define INDEX_SAVE_INTERVAL 32 // the index is saved every this number of insertions
+
+// blob file : sequence of records of [u32 url length][url][data]
+// index file : IndexHeader followed by IndexEntry * entry_num
+struct IndexHeader {
+	u32 magic;
+	u32 version;
+	u32 entry_num;
+};
+struct IndexEntry {
+	u64 url_hash;
+	u32 offset; // offset of the record in the blob file
+	u32 size;   // size of the data (excluding the url)
+	u32 last_used;
+};
+
+static Mutex resource_lock;
+static bool inited = false;
+static FILE *blob_fp = NULL; // NULL if the cache is unusable
+static u64 blob_size = 0;
+static std::unordered_map<u64, IndexEntry> index_entries;
+static u32 use_cnter = 0; // incremented each time when an entry is used
+static bool index_dirty = false;
+static int unsaved_insertion_num = 0;
+
+static AtomicFileIO index_atomic_io(INDEX_FILE_PATH, INDEX_FILE_TMP_PATH);
+
+static u64 get_url_hash(const std::string &url) { // FNV-1a
+	u64 res = 0xcbf29ce484222325ULL;
+	for (auto c : url) {
+		res = (res ^ (u8)c) * 0x100000001b3ULL;
+	}
+	return res;
+}
+static u64 get_record_size(const std::string &url, u32 data_size) { return sizeof(u32) + url.size() + data_size; }
+
+static bool is_valid_index(const std::string &data) {
+	if (data.size() < sizeof(IndexHeader)) {
+		return false;
+	}
+	IndexHeader header;
+	memcpy(&header, data.data(), sizeof(IndexHeader));
+	return header.magic == INDEX_MAGIC && header.version == INDEX_VERSION &&
+	       data.size() == sizeof(IndexHeader) + (u64)header.entry_num * sizeof(IndexEntry);
+}
+
+// the following functions must be called with resource_lock locked
+static void save_index() {
+	IndexHeader header = {INDEX_MAGIC, INDEX_VERSION, (u32)index_entries.size()};
+	std::string data((const char *)&header, sizeof(IndexHeader));
+	data.reserve(sizeof(IndexHeader) + index_entries.size() * sizeof(IndexEntry));
+	for (auto &i : index_entries) {
+		data.append((const char *)&i.second, sizeof(IndexEntry));
+	}
+	Result_with_string result = index_atomic_io.save(data);
+	if (result.code != 0) {
+		logger.error("thumb-cache", "index save failed : " + result.string + " " + std::to_string(result.code));
+	}
+	index_dirty = false;
+	unsaved_insertion_num = 0;
+}
+static void disable_cache(const std::string &reason) {
+	logger.error("thumb-cache", reason + ", disabling the cache");
+	if (blob_fp) {
+		fclose(blob_fp);
+		blob_fp = NULL;
+	}
+	index_entries.clear();
+}
+static bool read_record(const IndexEntry &entry, std::string &url, std::vector<u8> &data) {
+	u32 url_len;
+	if (fseek(blob_fp, entry.offset, SEEK_SET) != 0 || fread(&url_len, 1, sizeof(u32), blob_fp) != sizeof(u32) ||
+	    url_len > 0x1000) {
+		return false;
+	}
+	url.resize(url_len);
+	data.resize(entry.size);
+	return fread(&url[0], 1, url_len, blob_fp) == url_len && fread(&data[0], 1, entry.size, blob_fp) == entry.size;
+}
+static bool write_record(FILE *fp, const std::string &url, const u8 *data, u32 size) {
+	u32 url_len = url.size();
+	return fwrite(&url_len, 1, sizeof(u32), fp) == sizeof(u32) && fwrite(url.data(), 1, url_len, fp) == url_len &&
+	       fwrite(data, 1, size, fp) == size;
+}
+// rewrites the blob file with only the most recently used entries
+static void compact() {
+	std::vector<IndexEntry> entries;
+	for (auto &i : index_entries) {
+		entries.push_back(i.second);
+	}
+	std::sort(entries.begin(), entries.end(),
+	          [](const IndexEntry &i, const IndexEntry &j) { return i.last_used > j.last_used; });
+
+	FILE *tmp_fp = fopen(BLOB_FILE_TMP_PATH.c_str(), "wb");
+	if (!tmp_fp) {
+		disable_cache("fopen() failed on compaction");
+		return;
+	}
+	std::unordered_map<u64, IndexEntry> new_index_entries;
+	u64 new_blob_size = 0;
+	std::string url;
+	std::vector<u8> data;
+	bool write_failed = false;
+	for (auto entry : entries) {
+		if (!read_record(entry, url, data) || get_url_hash(url) != entry.url_hash) {
+			continue;
+		}
+		u64 record_size = get_record_size(url, entry.size);
+		if (new_blob_size + record_size > BLOB_SIZE_AFTER_COMPACTION) {
+			break;
+		}
+		if (!write_record(tmp_fp, url, data.data(), data.size())) {
+			write_failed = true;
+			break;
+		}
+		new_index_entries[entry.url_hash] = {entry.url_hash, (u32)new_blob_size, entry.size, entry.last_used};
+		new_blob_size += record_size;
+	}
+	fclose(tmp_fp);
+	fclose(blob_fp);
+	blob_fp = NULL;
+	if (write_failed) {
+		Path(BLOB_FILE_TMP_PATH).delete_file();
+		disable_cache("fwrite() failed on compaction");
+		return;
+	}
+
+	logger.info("thumb-cache", "compacted : " + std::to_string(index_entries.size()) + " -> " +
+	                               std::to_string(new_index_entries.size()) + " entries");
+	// the index is deleted first so that a crash in the middle never leaves an index pointing into the wrong blob
+	Path(INDEX_FILE_PATH).delete_file();
+	Path(INDEX_FILE_TMP_PATH).delete_file();
+	Path(BLOB_FILE_PATH).delete_file();
+	Path(BLOB_FILE_TMP_PATH).rename_to(BLOB_FILE_PATH);
+	blob_fp = fopen(BLOB_FILE_PATH.c_str(), "a+b");
+	if (!blob_fp) {
+		disable_cache("fopen() failed after compaction");
+		return;
+	}
+	index_entries = std::move(new_index_entries);
+	blob_size = new_blob_size;
+	save_index();
+}
+
+void thumbnail_disk_cache_init() {
+	resource_lock.lock();
+	if (inited) {
+		resource_lock.unlock();
+		return;
+	}
+	inited = true;
+
+	blob_fp = fopen(BLOB_FILE_PATH.c_str(), "a+b");
+	if (!blob_fp) {
+		// maybe the directory doesn't exist yet : write_file() creates it
+		Path(BLOB_FILE_PATH).write_file(NULL, 0);
+		blob_fp = fopen(BLOB_FILE_PATH.c_str(), "a+b");
+	}
+	if (!blob_fp || fseek(blob_fp, 0, SEEK_END) != 0) {
+		disable_cache("failed to open the blob file");
+		resource_lock.unlock();
+		return;
+	}
+	blob_size = ftell(blob_fp);
+
+	auto tmp = index_atomic_io.load(is_valid_index);
+	if (tmp.first.code == 0 && is_valid_index(tmp.second)) {
+		IndexHeader header;
+		memcpy(&header, tmp.second.data(), sizeof(IndexHeader));
+		for (u32 i = 0; i < header.entry_num; i++) {
+			IndexEntry entry;
+			memcpy(&entry, tmp.second.data() + sizeof(IndexHeader) + i * sizeof(IndexEntry), sizeof(IndexEntry));
+			if ((u64)entry.offset + entry.size > blob_size) {
+				continue; // the blob file was not written up to here
+			}
+			index_entries[entry.url_hash] = entry;
+			use_cnter = std::max(use_cnter, entry.last_used);
+		}
+	} else if (blob_size) {
+		logger.warning("thumb-cache", "index not available, discarding the blob file");
+		fclose(blob_fp);
+		blob_fp = fopen(BLOB_FILE_PATH.c_str(), "w+b");
+		blob_size = 0;
+		if (!blob_fp) {
+			disable_cache("failed to recreate the blob file");
+			resource_lock.unlock();
+			return;
+		}
+	}
+	logger.info("thumb-cache", "loaded " + std::to_string(index_entries.size()) + " entries (" +
+	                               std::to_string(blob_size) + " bytes)");
+	resource_lock.unlock();
+}
+void thumbnail_disk_cache_exit() {
+	resource_lock.lock();
+	if (blob_fp) {
+		if (index_dirty) {
+			save_index();
+		}
+		fclose(blob_fp);
+		blob_fp = NULL;
+	}
+	index_entries.clear();
+	inited = false;
+	resource_lock.unlock();
+}
+
+bool thumbnail_disk_cache_get(const std::string &url, std::vector<u8> &data) {
+	bool res = false;
+	resource_lock.lock();
+	u64 url_hash = get_url_hash(url);
+	if (blob_fp && index_entries.count(url_hash)) {
+		IndexEntry &entry = index_entries[url_hash];
+		std::string record_url;
+		if (read_record(entry, record_url, data) && record_url == url) {
+			entry.last_used = ++use_cnter;
+			index_dirty = true;
+			res = true;
+		} else {
+			logger.warning("thumb-cache", "broken entry : " + url);
+			index_entries.erase(url_hash);
+			data.clear();
+		}
+	}
+	resource_lock.unlock();
+	return res;
+}
+void thumbnail_disk_cache_put(const std::string &url, const std::vector<u8> &data) {
+	if (!data.size() || data.size() > ENTRY_SIZE_MAX) {
+		return;
+	}
+	resource_lock.lock();
+	u64 url_hash = get_url_hash(url);
+	if (blob_fp && !index_entries.count(url_hash)) {
+		u64 record_size = get_record_size(url, data.size());
+		if (blob_size + record_size > BLOB_SIZE_MAX) {
+			compact();
+		}
+		if (blob_fp) {
+			// the record is written before it's indexed so that the index never points to unwritten data
+			if (fseek(blob_fp, 0, SEEK_END) != 0 || !write_record(blob_fp, url, data.data(), data.size()) ||
+			    fflush(blob_fp) != 0) {
+				disable_cache("failed to write to the blob file");
+			} else {
+				index_entries[url_hash] = {url_hash, (u32)blob_size, (u32)data.size(), ++use_cnter};
+				blob_size += record_size;
+				index_dirty = true;
+				if (++unsaved_insertion_num >= INDEX_SAVE_INTERVAL) {
+					save_index();
+				}
+			}
+		}
+	}
+	resource_lock.unlock();
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <3ds.h>
+
+// persistent thumbnail cache on the SD card so that thumbnails survive app restarts
+// the data is stored in an append-only blob file, located through a compact index keyed by the hash of the url
+// once the blob file grows beyond the size limit, it is compacted down to the most recently used entries
+// all functions are thread-safe
+
+// loads the index from the SD card (does nothing if already loaded)
+void thumbnail_disk_cache_init();
+// writes the index back and closes the blob file
+void thumbnail_disk_cache_exit();
+
+// returns false if `url` is not cached
+bool thumbnail_disk_cache_get(const std::string &url, std::vector<u8> &data);
+void thumbnail_disk_cache_put(const std::string &url, const std::vector<u8> &data);
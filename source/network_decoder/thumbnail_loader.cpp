@@ -1,9 +1,13 @@
 #include "headers.hpp"
 #include "network_io.hpp"
 #include "thumbnail_loader.hpp"
+#include "thumbnail_disk_cache.hpp"
 #include <set>
 #include <map>
 #include <queue>
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
 
 static bool thread_network_session_list_inited = false;
 static NetworkSessionList thread_network_session_list;
@@ -33,12 +37,82 @@ static Mutex resource_lock;
 static std::vector<Request> requests;
 static std::queue<int> free_list;
 
-static std::map<std::string, std::vector<u8>> thumbnail_cache;
-static int thumbnail_free_time_cnter = 0; // incremented each time when a thumbnail is freed
-static std::map<std::string, int> thumbnail_free_time;
-
 #define THUMBNAIL_CACHE_MAX 300 // 4 KB * 300 = 1.2 MB
 
+// in-memory cache of the undecoded thumbnails
+// the thumbnails no longer requested form an LRU list (ordered by the time they were freed) and are evicted from its
+// front, the ones still requested are never evicted
+// every operation is O(1) and guarded by its own lock instead of resource_lock, which the UI thread takes every frame
+class ThumbnailMemoryCache {
+  private:
+	struct Entry {
+		std::vector<u8> data;
+		bool in_lru = false;
+		std::list<std::string>::iterator lru_pos; // valid only if `in_lru` is true
+	};
+	Mutex lock;
+	std::unordered_map<std::string, Entry> entries;
+	std::unordered_set<std::string> used_urls;
+	std::list<std::string> lru; // least recently freed first
+
+  public:
+	bool get(const std::string &url, std::vector<u8> &data) {
+		lock.lock();
+		auto entry = entries.find(url);
+		bool res = entry != entries.end();
+		if (res) {
+			data = entry->second.data;
+		}
+		lock.unlock();
+		return res;
+	}
+	void put(const std::string &url, const std::vector<u8> &data) {
+		std::vector<u8> evicted_data; // freed after unlocking
+		lock.lock();
+		auto entry = entries.find(url);
+		if (entry != entries.end()) {
+			entry->second.data = data;
+		} else {
+			if (entries.size() >= THUMBNAIL_CACHE_MAX && lru.size()) {
+				auto victim = entries.find(lru.front());
+				evicted_data.swap(victim->second.data);
+				entries.erase(victim);
+				lru.pop_front();
+			}
+			Entry &new_entry = entries[url];
+			new_entry.data = data;
+			if (!used_urls.count(url)) {
+				new_entry.in_lru = true;
+				new_entry.lru_pos = lru.insert(lru.end(), url);
+			}
+			if (entries.size() >= THUMBNAIL_CACHE_MAX + 10) {
+				logger.warning("tloader", "over caching : " + std::to_string(entries.size()));
+			}
+		}
+		lock.unlock();
+	}
+	// a thumbnail is 'used' while there's at least one request for it
+	void set_used(const std::string &url, bool used) {
+		lock.lock();
+		auto entry = entries.find(url);
+		if (used) {
+			used_urls.insert(url);
+			if (entry != entries.end() && entry->second.in_lru) {
+				lru.erase(entry->second.lru_pos);
+				entry->second.in_lru = false;
+			}
+		} else {
+			used_urls.erase(url);
+			if (entry != entries.end() && !entry->second.in_lru) {
+				entry->second.in_lru = true;
+				entry->second.lru_pos = lru.insert(lru.end(), url);
+			}
+		}
+		lock.unlock();
+	}
+};
+static ThumbnailMemoryCache thumbnail_cache;
+
 struct URLStatus {
 	std::set<int> handles;
 	bool is_loaded = false;
@@ -51,6 +125,105 @@ struct URLStatus {
 };
 static std::map<std::string, URLStatus> requested_urls;
 
+// max-heap of the urls waiting to be loaded keyed by their priority, where the priority of an existing url can be
+// updated in place
+class URLPriorityQueue {
+  public:
+	struct Item {
+		int priority;
+		std::string url;
+	};
+
+  private:
+	std::vector<Item> heap;
+	std::unordered_map<std::string, size_t> index; // url -> position in `heap`
+
+	void swap_items(size_t i, size_t j) {
+		std::swap(heap[i], heap[j]);
+		index[heap[i].url] = i;
+		index[heap[j].url] = j;
+	}
+	void sift_up(size_t i) {
+		while (i > 0 && heap[(i - 1) / 2].priority < heap[i].priority) {
+			swap_items(i, (i - 1) / 2);
+			i = (i - 1) / 2;
+		}
+	}
+	void sift_down(size_t i) {
+		while (true) {
+			size_t largest = i;
+			for (size_t child = i * 2 + 1; child <= i * 2 + 2 && child < heap.size(); child++) {
+				if (heap[child].priority > heap[largest].priority) {
+					largest = child;
+				}
+			}
+			if (largest == i) {
+				break;
+			}
+			swap_items(i, largest);
+			i = largest;
+		}
+	}
+
+  public:
+	size_t size() const { return heap.size(); }
+	const Item &top() const { return heap[0]; }
+	// inserts the url or updates its priority
+	void set(const std::string &url, int priority) {
+		auto pos = index.find(url);
+		if (pos == index.end()) {
+			index[url] = heap.size();
+			heap.push_back({priority, url});
+			sift_up(heap.size() - 1);
+		} else if (heap[pos->second].priority != priority) {
+			size_t i = pos->second;
+			heap[i].priority = priority;
+			sift_up(i);
+			sift_down(i);
+		}
+	}
+	void erase(const std::string &url) {
+		auto pos = index.find(url);
+		if (pos == index.end()) {
+			return;
+		}
+		size_t i = pos->second;
+		swap_items(i, heap.size() - 1);
+		index.erase(url);
+		heap.pop_back();
+		if (i < heap.size()) {
+			sift_up(i);
+			sift_down(i);
+		}
+	}
+	void pop() { erase(std::string(heap[0].url)); }
+};
+// the following are guarded by resource_lock
+static URLPriorityQueue download_queue;
+static std::multimap<time_t, std::string> retry_schedule; // next_retry -> url
+// the urls being downloaded or decoded, kept apart from requested_urls so that cancelling and requesting one again
+// while it's in flight doesn't schedule it twice
+static std::set<std::string> in_flight_urls;
+
+static int get_url_priority(const URLStatus &status) {
+	int priority = 0;
+	for (auto handle : status.handles) {
+		priority = std::max(priority, requests[handle].priority +
+		                                  (requests[handle].scene == active_scene ? PRIORITY_ACTIVE_SCENE : 0));
+	}
+	return priority;
+}
+// must be called with resource_lock locked whenever the state or the priority of the url may have changed
+static void update_schedule(const std::string &url) {
+	auto status = requested_urls.find(url);
+	if (status != requested_urls.end() && !status->second.is_loaded && !in_flight_urls.count(url) &&
+	    (!status->second.error || (status->second.waiting_retry && time(NULL) >= status->second.next_retry))) {
+		download_queue.set(url, get_url_priority(status->second));
+	} else {
+		download_queue.erase(url);
+	}
+}
+
 int thumbnail_request(const std::string &url, SceneType scene_id, int priority, ThumbnailType type) {
 	if (url == "") {
 		return -1;
@@ -67,7 +240,8 @@ int thumbnail_request(const std::string &url, SceneType scene_id, int priority,
 	}
 	requested_urls[url].handles.insert(handle);
 	requested_urls[url].type = type;
-	thumbnail_free_time.erase(url);
+	update_schedule(url);
+	thumbnail_cache.set_used(url, true);
 	resource_lock.unlock();
 	if (requests.size() > 180) {
 		logger.warning("tloader",
@@ -87,8 +261,9 @@ inline static void thumbnail_cancel_request_wo_lock(int handle) {
 			Draw_c2d_image_free(url_status.data.data);
 		}
 		requested_urls.erase(url);
-		thumbnail_free_time[url] = ++thumbnail_free_time_cnter;
+		thumbnail_cache.set_used(url, false);
 	}
+	update_schedule(url);
 	free_list.push(handle);
 }
 void thumbnail_cancel_request(int handle) {
@@ -113,7 +288,10 @@ void thumbnail_set_priority(int handle, int value) {
 		return;
 	}
 	resource_lock.lock();
-	requests[handle].priority = value;
+	if (requests[handle].priority != value) {
+		requests[handle].priority = value;
+		update_schedule(requests[handle].url);
+	}
 	resource_lock.unlock();
 }
 void thumbnail_set_priorities(const std::vector<std::pair<int, int>> &priority_list) {
@@ -122,11 +300,24 @@ void thumbnail_set_priorities(const std::vector<std::pair<int, int>> &priority_l
 		if (i.first == -1) {
 			continue;
 		}
-		requests[i.first].priority = i.second;
+		if (requests[i.first].priority != i.second) {
+			requests[i.first].priority = i.second;
+			update_schedule(requests[i.first].url);
+		}
+	}
+	resource_lock.unlock();
+}
+void thumbnail_set_active_scene(SceneType type) {
+	if (active_scene == type) {
+		return;
+	}
+	resource_lock.lock();
+	active_scene = type;
+	for (auto &i : requested_urls) {
+		update_schedule(i.first);
 	}
 	resource_lock.unlock();
 }
-void thumbnail_set_active_scene(SceneType type) { active_scene = type; }
 
 bool thumbnail_is_available(const std::string &url) {
 	if (url == "") {
@@ -180,13 +371,7 @@ bool thumbnail_draw(int handle, int x_offset, int y_offset, int x_len, int y_len
 
 static std::vector<u8> http_get(const std::string &url, int &status_code) {
 	std::vector<u8> res;
-	resource_lock.lock();
-	if (thumbnail_cache.count(url)) {
-		res = thumbnail_cache[url];
-	}
-	resource_lock.unlock();
-
-	if (res.size()) {
+	if (thumbnail_cache.get(url, res) || thumbnail_disk_cache_get(url, res)) {
 		status_code = 0;
 		return res;
 	}
@@ -198,63 +383,245 @@ static std::vector<u8> http_get(const std::string &url, int &status_code) {
 		logger.error("thumb-dl", "access fail : " + result.error);
 	} else {
 		if (result.data.size() && result.status_code / 100 == 2) {
+			thumbnail_cache.put(url, result.data);
+			thumbnail_disk_cache_put(url, result.data);
+		}
+		status_code = result.status_code;
+	}
+	return result.data;
+}
+
+// decoding (and uploading to textures) is done by a small pool of worker threads so that it doesn't stall downloading
+#define THUMBNAIL_BATCH_MAX 32 // maximum number of thumbnails loaded at once
+#define DECODE_WORKER_MAX 3
+#define DECODE_QUEUE_MAX 8 // the downloader waits if more thumbnails than this are waiting to be decoded
+#define DECODE_WORKER_WAIT_TIMEOUT_NS (50 * 1000 * 1000)
+
+struct DecodeJob {
+	int priority;
+	std::string url;
+	ThumbnailType type;
+	NetworkResult result; // status_code is 0 if the data came from a cache
+	u64 enqueue_tick;
+
+	bool operator<(const DecodeJob &rhs) const { return priority < rhs.priority; }
+};
+struct DecodeStats {
+	int decoded_num = 0;
+	u64 queue_wait_ticks = 0; // summed over the jobs
+	u64 decode_ticks = 0;     // summed over the jobs
+};
+
+static Mutex decode_queue_lock;
+static std::vector<DecodeJob> decode_queue; // binary heap, highest priority first
+static DecodeStats decode_stats;            // since the last log
+static Event decode_queue_event; // signaled when a job is pushed or the workers are requested to exit
+static Event decode_done_event;  // signaled when a job is done
+static volatile bool decode_workers_exit_request = false;
+static Thread decode_workers[DECODE_WORKER_MAX];
+static int decode_worker_num = 0;
+
+static u64 ticks_to_ms(u64 ticks) { return ticks * 1000 / SYSCLOCK_ARM11; }
+
+static void load_thumbnail(DecodeJob &job) {
+	const NetworkResult &res = job.result;
+
+	// some special operations on the picture here (it shouldn't be here but...)
+	// for video thumbnail, crop to 16:9
+	float radius = 0;
+	auto crop = [&](int w, int h, int &top, int &new_h) {
+		if (job.type == ThumbnailType::VIDEO_THUMBNAIL && h > w * 9 / 16 + 1) {
+			new_h = w * 9 / 16;
+			top = (h - new_h) / 2;
+		}
+		radius = (float)new_h / 2;
+	};
+	// channel icon : round (definitely not the recommended way but we will fill the area outside the circle
+	// with white)
+	auto round = [&](u16 pixel, int x, int y) -> u16 {
+		float distance = std::hypot(radius - (y + 0.5), radius - (x + 0.5));
+		u8 b = pixel & ((1 << 5) - 1);
+		u8 g = (pixel >> 5) & ((1 << 6) - 1);
+		u8 r = pixel >> 11;
+		float proportion = std::max(0.0f, std::min(1.0f, radius + 0.5f - distance));
+		b = b * proportion + (var_night_mode ? 0 : ((1 << 5) - 1)) * (1 - proportion);
+		g = g * proportion + (var_night_mode ? 0 : ((1 << 6) - 1)) * (1 - proportion);
+		r = r * proportion + (var_night_mode ? 0 : ((1 << 5) - 1)) * (1 - proportion);
+		return b | g << 5 | r << 11;
+	};
+
+	int w, h;
+	Image_data result_image;
+	Result_with_string result;
+	result.code = DEF_ERR_STB_IMG_RETURNED_NOT_SUCCESS;
+	if (res.data.size()) {
+		result = Image_decode_to_texture(
+		    &res.data[0], res.data.size(), &result_image, &w, &h, crop,
+		    job.type == ThumbnailType::ICON ? std::function<u16(u16, int, int)>(round) : nullptr);
+	}
+	if (result.code != DEF_ERR_STB_IMG_RETURNED_NOT_SUCCESS) {
+		// update cache
+		thumbnail_cache.put(job.url, res.data);
+		if (res.status_code != 0) { // freshly downloaded
+			thumbnail_disk_cache_put(job.url, res.data);
+		}
+
+		if (result.code != 0) {
+			logger.error("thumb-dl", "out of linearmem");
+		} else {
 			resource_lock.lock();
-			if (thumbnail_cache.size() >= THUMBNAIL_CACHE_MAX) {
-				std::string erase_url;
-				int min_time = 1000000000;
-				for (auto &item : thumbnail_cache) {
-					if (!thumbnail_free_time.count(item.first)) {
-						continue;
-					}
-					int cur_time = thumbnail_free_time[item.first];
-					if (min_time > cur_time) {
-						min_time = cur_time;
-						erase_url = item.first;
-					}
-				}
-				if (erase_url != "") {
-					thumbnail_cache.erase(erase_url);
-				}
+			auto status = requested_urls.find(job.url);
+			// the request may have been cancelled while downloading, or cancelled and made again and loaded already
+			if (status != requested_urls.end() && !status->second.is_loaded) {
+				status->second.is_loaded = true;
+				status->second.data = {w, h, result_image.c2d.tex->width, result_image.c2d.tex->height, result_image};
+			} else {
+				Draw_c2d_image_free(result_image);
+			}
+			resource_lock.unlock();
+		}
+	} else {
+		resource_lock.lock();
+		if (requested_urls.count(job.url)) {
+			requested_urls[job.url].is_loaded = false;
+			requested_urls[job.url].error = true;
+			if (res.status_code / 100 != 4 && res.status_code / 100 != 2) {
+				requested_urls[job.url].waiting_retry = true;
+				requested_urls[job.url].next_retry = time(NULL) + 3;
+				retry_schedule.insert({requested_urls[job.url].next_retry, job.url});
+			} else {
+				requested_urls[job.url].waiting_retry = false;
 			}
-			thumbnail_cache[url] = result.data;
+			requested_urls[job.url].last_status_code = res.status_code;
+		}
+		resource_lock.unlock();
+		std::string err_msg = "load failed (http code : " + std::to_string(res.status_code) +
+		                      ") size:" + std::to_string(res.data.size()) + " err:" + res.error;
+
+		logger.error("thumb-dl", err_msg);
+	}
 
-			if (thumbnail_cache.size() >= THUMBNAIL_CACHE_MAX + 10) {
-				logger.warning("tloader", "over caching : " + std::to_string(thumbnail_cache.size()));
+	resource_lock.lock();
+	in_flight_urls.erase(job.url);
+	update_schedule(job.url); // e.g. the texture allocation failed : retried in the next batch
+	resource_lock.unlock();
+}
+
+static void decode_worker_thread_func(void *arg) {
+	while (true) {
+		decode_queue_lock.lock();
+		if (!decode_queue.size()) {
+			decode_queue_lock.unlock();
+			if (decode_workers_exit_request) {
+				break;
 			}
+			decode_queue_event.wait(DECODE_WORKER_WAIT_TIMEOUT_NS);
+			continue;
+		}
+		std::pop_heap(decode_queue.begin(), decode_queue.end());
+		DecodeJob job = std::move(decode_queue.back());
+		decode_queue.pop_back();
+		bool job_left = decode_queue.size();
+		decode_queue_lock.unlock();
+		if (job_left) {
+			decode_queue_event.signal(); // pass the wake-up on to another worker
+		}
 
-			resource_lock.unlock();
+		u64 decode_start_tick = svcGetSystemTick();
+		load_thumbnail(job);
+		u64 decode_end_tick = svcGetSystemTick();
+
+		decode_queue_lock.lock();
+		decode_stats.decoded_num++;
+		decode_stats.queue_wait_ticks += decode_start_tick - job.enqueue_tick;
+		decode_stats.decode_ticks += decode_end_tick - decode_start_tick;
+		decode_queue_lock.unlock();
+		decode_done_event.signal();
+	}
+	threadExit(0);
+}
+static void start_decode_workers() {
+	decode_workers_exit_request = false;
+	// one worker on the same core as the downloader, and one on each extra core of New 3DS (with a lower priority so
+	// that they don't get in the way of the video decoder)
+	decode_workers[decode_worker_num] = threadCreate(decode_worker_thread_func, NULL, DEF_STACKSIZE,
+	                                                 DEF_THREAD_PRIORITY_NORMAL, 0, false);
+	if (decode_workers[decode_worker_num]) {
+		decode_worker_num++;
+	}
+	for (int core : {2, 3}) {
+		if ((core == 2 && !var_core2_available) || (core == 3 && !var_core3_available)) {
+			continue;
+		}
+		decode_workers[decode_worker_num] =
+		    threadCreate(decode_worker_thread_func, NULL, DEF_STACKSIZE, DEF_THREAD_PRIORITY_LOW, core, false);
+		if (decode_workers[decode_worker_num]) {
+			decode_worker_num++;
 		}
-		status_code = result.status_code;
 	}
-	return result.data;
+	if (!decode_worker_num) {
+		logger.error("thumb-dl", "failed to create any decode worker");
+	}
+}
+static void stop_decode_workers() {
+	decode_workers_exit_request = true;
+	for (int i = 0; i < decode_worker_num; i++) {
+		decode_queue_event.signal();
+	}
+	for (int i = 0; i < decode_worker_num; i++) {
+		threadJoin(decode_workers[i], U64_MAX);
+		threadFree(decode_workers[i]);
+		decode_workers[i] = NULL;
+	}
+	decode_worker_num = 0;
+}
+static void push_decode_job(DecodeJob &&job) {
+	if (!decode_worker_num) { // no worker to hand it to
+		load_thumbnail(job);
+		return;
+	}
+	decode_queue_lock.lock();
+	while (decode_queue.size() >= DECODE_QUEUE_MAX) {
+		decode_queue_lock.unlock();
+		// timed so that a missed signal only costs a timeout instead of stalling the downloader forever
+		decode_done_event.wait(DECODE_WORKER_WAIT_TIMEOUT_NS);
+		decode_queue_lock.lock();
+	}
+	job.enqueue_tick = svcGetSystemTick();
+	decode_queue.push_back(std::move(job));
+	std::push_heap(decode_queue.begin(), decode_queue.end());
+	decode_queue_lock.unlock();
+	decode_queue_event.signal();
 }
 
 static bool should_be_running = true;
 void thumbnail_downloader_thread_func(void *arg) {
+	thumbnail_disk_cache_init();
+	start_decode_workers();
 	while (should_be_running) {
 		resource_lock.lock();
+		time_t now = time(NULL);
+		while (retry_schedule.size() && retry_schedule.begin()->first <= now) {
+			std::string url = retry_schedule.begin()->second;
+			retry_schedule.erase(retry_schedule.begin());
+			update_schedule(url);
+		}
 		struct Item {
 			int priority;
 			std::string url;
 			ThumbnailType type;
 		};
 		std::vector<Item> download_list;
-		{
-			for (auto &i : requested_urls) {
-				if (i.second.is_loaded) {
-					continue;
-				}
-				if (i.second.error && (!i.second.waiting_retry || time(NULL) < i.second.next_retry)) {
-					continue;
-				}
-				int priority = 0;
-				for (auto handle : i.second.handles) {
-					priority =
-					    std::max(priority, requests[handle].priority +
-					                           (requests[handle].scene == active_scene ? PRIORITY_ACTIVE_SCENE : 0));
-				}
-				download_list.push_back({priority, i.first, i.second.type});
+		while (download_list.size() < THUMBNAIL_BATCH_MAX && download_queue.size()) {
+			auto top = download_queue.top();
+			// load thumbnails in the foreground first
+			if (download_list.size() && download_list[0].priority >= PRIORITY_ACTIVE_SCENE + PRIORITY_FOREGROUND &&
+			    top.priority < PRIORITY_ACTIVE_SCENE + PRIORITY_FOREGROUND) {
+				break;
 			}
+			download_queue.pop();
+			in_flight_urls.insert(top.url);
+			download_list.push_back({top.priority, top.url, requested_urls[top.url].type});
 		}
 		resource_lock.unlock();
 
@@ -263,174 +630,53 @@ void thumbnail_downloader_thread_func(void *arg) {
 			continue;
 		}
 
-		// sort in the decreasing order of the priority
-		std::sort(download_list.begin(), download_list.end(),
-		          [](const auto &i, const auto &j) { return i.priority > j.priority; });
-
-		std::string priority_str;
-		for (auto i : download_list) {
-			priority_str += std::to_string(i.priority) + " ";
-		}
-		if (download_list[0].priority >=
-		    PRIORITY_ACTIVE_SCENE + PRIORITY_FOREGROUND) { // load thumbnails in the foreground first
-			while (download_list.back().priority < PRIORITY_ACTIVE_SCENE + PRIORITY_FOREGROUND) {
-				download_list.pop_back();
-			}
-		}
-
-		std::vector<NetworkResult> results(download_list.size());
+		u64 batch_start_tick = svcGetSystemTick();
+		// cached thumbnails go straight to the decoders
 		std::vector<int> uncached_index_list;
-		std::vector<int> cached_index_list;
+		size_t cached_num = 0;
 		for (size_t i = 0; i < download_list.size(); i++) {
-			if (thumbnail_cache.count(download_list[i].url)) {
-				results[i].status_code = 0; // cached
-				results[i].data = thumbnail_cache[download_list[i].url];
-				cached_index_list.push_back(i);
+			NetworkResult cached_result;
+			if (thumbnail_cache.get(download_list[i].url, cached_result.data) ||
+			    thumbnail_disk_cache_get(download_list[i].url, cached_result.data)) {
+				cached_result.status_code = 0; // cached
+				push_decode_job({download_list[i].priority, download_list[i].url, download_list[i].type,
+				                 std::move(cached_result), 0});
+				cached_num++;
 			} else {
 				uncached_index_list.push_back(i);
 			}
 		}
-
-		auto load_downloaded_thumbnail = [&](int i) {
-			auto &res = results[i];
-			auto &info = download_list[i];
-
-			int w, h;
-			u8 *decoded_data = NULL;
-			if (res.data.size()) {
-				decoded_data = Image_decode(&res.data[0], res.data.size(), &w, &h);
-			}
-			if (decoded_data) {
-				// update cache
-				resource_lock.lock();
-				if (thumbnail_cache.size() >= THUMBNAIL_CACHE_MAX) {
-					std::string erase_url;
-					int min_time = 1000000000;
-					for (auto &item : thumbnail_cache) {
-						if (!thumbnail_free_time.count(item.first)) {
-							continue;
-						}
-						int cur_time = thumbnail_free_time[item.first];
-						if (min_time > cur_time) {
-							min_time = cur_time;
-							erase_url = item.first;
-						}
-					}
-					if (erase_url != "") {
-						thumbnail_cache.erase(erase_url);
-					}
-				}
-				thumbnail_cache[info.url] = res.data;
-				if (thumbnail_cache.size() >= THUMBNAIL_CACHE_MAX + 10) {
-					logger.warning("tloader", "over caching : " + std::to_string(thumbnail_cache.size()));
-				}
-				resource_lock.unlock();
-
-				// some special operations on the picture here (it shouldn't be here but...)
-				// for video thumbnail, crop to 16:9
-				if (info.type == ThumbnailType::VIDEO_THUMBNAIL && h > w * 9 / 16 + 1) {
-					int new_h = w * 9 / 16;
-					int vertical_offset = (h - new_h) / 2;
-					memmove(decoded_data, decoded_data + vertical_offset * w * 2, new_h * w * 2);
-					h = new_h;
-				}
-				// channel icon : round (definitely not the recommended way but we will fill the area outside the circle
-				// with white)
-				if (info.type == ThumbnailType::ICON) {
-					float radius = (float)h / 2;
-					for (int i = 0; i < h; i++) {
-						for (int j = 0; j < w; j++) {
-							float distance = std::hypot(radius - (i + 0.5), radius - (j + 0.5));
-							u8 b = decoded_data[(i * w + j) * 2 + 0] & ((1 << 5) - 1);
-							u8 g = (decoded_data[(i * w + j) * 2 + 0] >> 5) |
-							       ((decoded_data[(i * w + j) * 2 + 1] & ((1 << 3) - 1)) << 3);
-							u8 r = decoded_data[(i * w + j) * 2 + 1] >> 3;
-							float proportion = std::max(0.0f, std::min(1.0f, radius + 0.5f - distance));
-							b = b * proportion + (var_night_mode ? 0 : ((1 << 5) - 1)) * (1 - proportion);
-							g = g * proportion + (var_night_mode ? 0 : ((1 << 6) - 1)) * (1 - proportion);
-							r = r * proportion + (var_night_mode ? 0 : ((1 << 5) - 1)) * (1 - proportion);
-							decoded_data[(i * w + j) * 2 + 0] = b | g << 5;
-							decoded_data[(i * w + j) * 2 + 1] = g >> 3 | r << 3;
-						}
-					}
-				}
-
-				Image_data result_image;
-				int texture_w = 1;
-				while (texture_w < w) {
-					texture_w <<= 1;
-				}
-				int texture_h = 1;
-				while (texture_h < h) {
-					texture_h <<= 1;
-				}
-
-				Result_with_string result;
-				result = Draw_c2d_image_init(&result_image, texture_w, texture_h, GPU_RGB565);
-				if (result.code != 0) {
-					logger.error("thumb-dl", "out of linearmem");
-				} else {
-					result = Draw_set_texture_data(&result_image, decoded_data, w, h, texture_w, texture_h, GPU_RGB565);
-					if (result.code != 0) {
-						logger.error("thumb-dl", "Draw_set_texture_data() failed");
-					} else {
-						resource_lock.lock();
-						if (requested_urls.count(info.url)) { // in case the request is cancelled while downloading
-							requested_urls[info.url].is_loaded = true;
-							requested_urls[info.url].data = {w, h, texture_w, texture_h, result_image};
-						}
-						resource_lock.unlock();
-					}
-				}
-				free(decoded_data);
-				decoded_data = NULL;
-			} else {
-				resource_lock.lock();
-				if (requested_urls.count(info.url)) {
-					requested_urls[info.url].is_loaded = false;
-					requested_urls[info.url].error = true;
-					if (res.status_code / 100 != 4 && res.status_code / 100 != 2) {
-						requested_urls[info.url].waiting_retry = true;
-						requested_urls[info.url].next_retry = time(NULL) + 3;
-					} else {
-						requested_urls[info.url].waiting_retry = false;
-					}
-					requested_urls[info.url].last_status_code = res.status_code;
-				}
-				resource_lock.unlock();
-				std::string err_msg = "load failed (http code : " + std::to_string(res.status_code) +
-				                      ") size:" + std::to_string(res.data.size()) + " err:" + res.error;
-
-				logger.error("thumb-dl", err_msg);
-			}
-		};
-		TickCounter counter;
-		osTickCounterStart(&counter);
-		// Util_log_save("thumb-dl", "load cached : " + std::to_string(cached_index_list.size()));
-		osTickCounterUpdate(&counter);
-		for (auto i : cached_index_list) {
-			load_downloaded_thumbnail(i);
-		}
-		osTickCounterUpdate(&counter);
-		// Util_log_save("thumb-dl", std::to_string((int) osTickCounterRead(&counter)) + " ms");
-
-		// Util_log_save("thumb-dl", "start dl : " + std::to_string(uncached_index_list.size()));
-		// load uncached thumbnails
-		{
+		// the uncached ones are handed to the decoders as soon as each of them is downloaded, so that decoding never
+		// blocks the curl loop for long (it only waits if the decode queue is full)
+		if (uncached_index_list.size()) {
 			confirm_thread_network_session_list_inited();
 			std::vector<HttpRequest> requests;
 			for (auto i : uncached_index_list) {
 				requests.push_back(HttpRequest::GET(download_list[i].url, {})
 				                       .with_on_finish_callback([&](NetworkResult &res, int index) {
-					                       results[uncached_index_list[index]] = res;
-					                       load_downloaded_thumbnail(uncached_index_list[index]);
+					                       auto &item = download_list[uncached_index_list[index]];
+					                       push_decode_job({item.priority, item.url, item.type, std::move(res), 0});
 				                       }));
 			}
 			thread_network_session_list.perform(requests);
 		}
-		osTickCounterUpdate(&counter);
-		// Util_log_save("thumb-dl", std::to_string((int) osTickCounterRead(&counter)) + " ms");
+		u64 download_end_tick = svcGetSystemTick();
+		// the next batch is built right away without waiting for the decoders : the urls of this batch stay in flight
+		// until they are loaded, so they are never scheduled twice, and the decode queue never runs dry between batches
+		decode_queue_lock.lock();
+		DecodeStats stats = decode_stats;
+		decode_stats = DecodeStats();
+		decode_queue_lock.unlock();
+		logger.info("thumb-dl", std::to_string(cached_num) + " cached + " +
+		                            std::to_string(uncached_index_list.size()) + " downloaded, dl:" +
+		                            std::to_string(ticks_to_ms(download_end_tick - batch_start_tick)) + "ms, " +
+		                            std::to_string(stats.decoded_num) +
+		                            " decoded since the last batch, queue wait:" +
+		                            std::to_string(ticks_to_ms(stats.queue_wait_ticks)) +
+		                            "ms decode:" + std::to_string(ticks_to_ms(stats.decode_ticks)) + "ms (" +
+		                            std::to_string(decode_worker_num) + " workers)");
 	}
+	stop_decode_workers();
 
 	resource_lock.lock();
 	for (auto i : requested_urls) {
@@ -439,7 +685,9 @@ void thumbnail_downloader_thread_func(void *arg) {
 		}
 	}
 	requested_urls.clear();
+	in_flight_urls.clear();
 	resource_lock.unlock();
+	thumbnail_disk_cache_exit();
 
 	logger.info("thumb-dl", "Thread exit.");
 	threadExit(0);
@@ -4,13 +4,52 @@
 #include "rapidjson/stringbuffer.h"
 #include <vector>
 #include <string>
+#include <cstring>
+
+class RJsonArray;
 
 // rapidjson wrapper
 class RJson {
   private:
 	rapidjson::Value *json = NULL;
+	// the member found by the last lookup, as has_key(key) is usually followed by [key]
+	// it's checked to still be a member of `json` before being used, so it's safe even after the object is modified
+	mutable rapidjson::Value::Member *last_member = NULL;
+
+	rapidjson::Value *find_member(const char *key) const {
+		if (!json || !json->IsObject()) {
+			return NULL;
+		}
+		if (last_member && json->MemberCount()) {
+			rapidjson::Value::Member *members = &*json->MemberBegin();
+			if (last_member >= members && last_member < members + json->MemberCount() &&
+			    !strcmp(last_member->name.GetString(), key)) {
+				return &last_member->value;
+			}
+		}
+		auto itr = json->FindMember(key);
+		if (itr == json->MemberEnd()) {
+#ifdef YT_PARSER_FILTER_DEBUG
+			if (key_not_found_hook()) {
+				key_not_found_hook()(*json, key);
+			}
+#endif
+			return NULL;
+		}
+		last_member = &*itr;
+		return &itr->value;
+	}
 
   public:
+#ifdef YT_PARSER_FILTER_DEBUG
+	// called when a key is looked up in an object without it (the youtube parser uses it to detect filtering mistakes)
+	using key_not_found_hook_t = void (*)(const rapidjson::Value &object, const char *key);
+	static key_not_found_hook_t &key_not_found_hook() {
+		static key_not_found_hook_t hook = NULL;
+		return hook;
+	}
+#endif
+
 	RJson() {}
 	RJson(const RJson &rhs) = default;
 	RJson(rapidjson::Value &json) : json(&json) {}
@@ -38,26 +77,22 @@ class RJson {
 	}
 
 	bool is_valid() const { return json != NULL; }
-	bool has_key(const std::string &str) const { return (*this)[str].is_valid(); }
+	bool has_key(const char *key) const { return find_member(key) != NULL; }
+	bool has_key(const std::string &str) const { return find_member(str.c_str()) != NULL; }
 
 	const char *cstring_value() const { return json && json->IsString() ? json->GetString() : ""; }
 	std::string string_value() const { return cstring_value(); }
 	int int_value() const { return json && json->IsInt() ? json->GetInt() : 0; }
 	bool bool_value() const { return json && json->IsBool() ? json->GetBool() : false; }
-	std::vector<RJson> array_items() const {
-		if (!json || !json->IsArray()) {
-			return {};
-		}
-		const auto &array = json->GetArray();
-		return std::vector<RJson>(array.Begin(), array.End());
-	}
+	// a view of the elements, no allocation is involved
+	RJsonArray array_items() const;
 
 	void set_str(rapidjson::Document &json_root, const char *key, const char *value) {
 		if (!json || !json->IsObject()) {
 			return;
 		}
-		if (has_key(key)) {
-			(*this)[key].json->SetString(value, json_root.GetAllocator());
+		if (rapidjson::Value *member = find_member(key)) {
+			member->SetString(value, json_root.GetAllocator());
 		} else {
 			rapidjson::Value value_object;
 			value_object.SetString(value, json_root.GetAllocator());
@@ -68,7 +103,8 @@ class RJson {
 	}
 
 	RJson operator[](const char *key) const {
-		return json && json->IsObject() && json->HasMember(key) ? (*json)[key] : RJson();
+		rapidjson::Value *member = find_member(key);
+		return member ? RJson(*member) : RJson();
 	}
 	RJson operator[](const std::string &str) const { return (*this)[str.c_str()]; }
 	RJson operator[](size_t index) const { return json && json->IsArray() ? (*json)[index] : RJson(); }
@@ -83,3 +119,40 @@ class RJson {
 		return buffer.GetString();
 	}
 };
+
+// the elements of an array, valid while the array is alive and not modified
+class RJsonArray {
+	rapidjson::Value *items = NULL;
+	size_t num = 0;
+
+  public:
+	class iterator {
+		rapidjson::Value *cur;
+
+	  public:
+		iterator(rapidjson::Value *cur) : cur(cur) {}
+		RJson operator*() const { return RJson(*cur); }
+		iterator &operator++() {
+			cur++;
+			return *this;
+		}
+		bool operator==(const iterator &rhs) const { return cur == rhs.cur; }
+		bool operator!=(const iterator &rhs) const { return cur != rhs.cur; }
+	};
+
+	RJsonArray() {}
+	RJsonArray(rapidjson::Value *items, size_t num) : items(items), num(num) {}
+
+	iterator begin() const { return iterator(items); }
+	iterator end() const { return iterator(items + num); }
+	size_t size() const { return num; }
+	bool empty() const { return num == 0; }
+	RJson operator[](size_t index) const { return index < num ? RJson(items[index]) : RJson(); }
+};
+
+inline RJsonArray RJson::array_items() const {
+	if (!json || !json->IsArray()) {
+		return RJsonArray();
+	}
+	return RJsonArray(json->Begin(), json->Size());
+}
@@ -787,6 +787,20 @@ void Sem_init(void) {
 							}
 						}),
 					(new EmptyView(0, 0, 320, 10)),
+					// Export the player telemetry to the SD card
+					(new SelectorView(0, 0, 320, 35, true))
+						->set_texts({
+							(std::function<std::string ()>) []() { return LOCALIZED(OFF); },
+							(std::function<std::string ()>) []() { return LOCALIZED(ON); }
+						}, var_video_telemetry_export)
+						->set_title([](const SelectorView &view) { return LOCALIZED(VIDEO_TELEMETRY_EXPORT); })
+						->set_on_change([](const SelectorView &view) {
+							if (var_video_telemetry_export != view.selected_button) {
+								var_video_telemetry_export = view.selected_button;
+								misc_tasks_request(TASK_SAVE_SETTINGS);
+							}
+						}),
+					(new EmptyView(0, 0, 320, 10)),
                     // Select app data to use
                     (new SelectorView(0, 0, 320, 35, false))
                         ->set_texts({
@@ -14,6 +14,7 @@
 #include "util/async_task.hpp"
 #include "util/misc_tasks.hpp"
 #include "util/util.hpp"
+#include "util/telemetry.hpp"
 #include "data_io/subscription_util.hpp"
 
 #define ICON_SIZE 55
@@ -55,7 +56,7 @@ volatile bool audio_only_mode = false;
 volatile bool video_skip_drawing = false; // for performance reason, enabled when opening keyboard
 volatile int video_p_value = 360;
 volatile double seek_at_init_request = -1;
-double vid_time[2][320];
+PlayerTelemetry vid_telemetry;
 double vid_copy_time[2] = {
     0,
     0,
@@ -75,8 +76,6 @@ volatile double vid_seek_pos = 0;
 double vid_min_time = 0;
 double vid_max_time = 0;
 double vid_total_time = 0;
-double vid_recent_time[90];
-double vid_recent_total_time = 0;
 int vid_total_frames = 0;
 int vid_width = 0;
 int vid_width_org = 0;
@@ -96,6 +95,14 @@ C2D_Image vid_control[2];
 C2D_Image play_button_texture[2];
 Thread vid_decode_thread, vid_convert_thread;
 
+// late-frame policy (in seconds of lag behind the audio clock)
+constexpr double LATE_FRAME_THRESHOLD = 0.04;        // frames later than this are neither converted nor uploaded
+constexpr double LATE_FRAME_MAX_DRAW_INTERVAL = 0.5; // ...unless no frame has been drawn for this long
+constexpr double DECODER_SKIP_ON_THRESHOLD = 0.25;   // the decoder skips non-reference frames beyond this lag
+constexpr double DECODER_SKIP_OFF_THRESHOLD = 0.05;  // ...until the lag gets below this
+volatile int vid_late_frames = 0;
+volatile int vid_dropped_frames = 0;
+
 constexpr int CONTENT_Y_HIGH =
     240 - TAB_SELECTOR_HEIGHT - VIDEO_PLAYING_BAR_HEIGHT; // the bar is always shown here, so this is a constant
 
@@ -103,6 +110,7 @@ Thread stream_downloader_thread;
 NetworkStreamDownloader stream_downloader;
 
 Thread livestream_initer_thread;
+Thread demux_thread;
 NetworkMultipleDecoder network_decoder;
 Mutex network_decoder_critical_lock; // locked when seeking or deiniting
 
@@ -182,6 +190,7 @@ static void load_more_comments(void *);
 static void load_more_suggestions(void *);
 static void load_more_replies(void *);
 static void load_caption(void *);
+static void export_telemetry(void *);
 
 static void decode_thread(void *arg);
 static void convert_thread(void *arg);
@@ -236,7 +245,7 @@ void VideoPlayer_init(void) {
 	debug_info_view =
 	    (new VerticalListView(0, 0, 320))
 	        ->set_views(
-	            {(new TextView(SMALL_MARGIN, 0, 320, DEFAULT_FONT_INTERVAL * 8))
+	            {(new TextView(SMALL_MARGIN, 0, 320, DEFAULT_FONT_INTERVAL * 12))
 	                 ->set_text_lines<std::function<std::string()>>(
 	                     {[]() { return vid_video_format; }, []() { return vid_audio_format; },
 	                      []() {
@@ -274,26 +283,58 @@ void VideoPlayer_init(void) {
 		                      return LOCALIZED(RAW_FRAME_BUFFER) + " : " +
 		                             std::to_string(network_decoder.get_raw_buffer_num()) + "/" +
 		                             std::to_string(network_decoder.get_raw_buffer_num_max());
+	                      },
+	                      []() {
+		                      auto stats = network_decoder.get_video_output_stats();
+		                      return "Frame buffer allocs : " + std::to_string(stats.alloc_num) + " (" +
+		                             std::to_string(stats.frame_num) + " frames, " +
+		                             std::to_string(stats.copied_frame_num) + " copied)";
+	                      },
+	                      []() {
+		                      auto depth = network_decoder.get_packet_queue_depth();
+		                      return "Packet queue : " + std::to_string(depth.video) + " / " +
+		                             std::to_string(depth.audio);
+	                      },
+	                      []() {
+		                      return "Late/dropped frames : " + std::to_string(vid_late_frames) + "/" +
+		                             std::to_string(vid_dropped_frames) +
+		                             (network_decoder.get_skip_non_ref_frames() ? " (skipping)" : "");
+	                      },
+	                      []() {
+		                      auto stats = network_decoder.get_cache_stats();
+		                      return "Cache hit/miss/evict : " + std::to_string(stats.hit_num) + "/" +
+		                             std::to_string(stats.miss_num) + "/" + std::to_string(stats.evicted_num);
 	                      }}),
 	             (new RuleView(0, 0, 320, SMALL_MARGIN * 2)),
 	             (new CustomView(0, 0, 320, 160))->set_draw([](const CustomView &view) {
 		             int y = view.y0;
 
-		             // decoding time graph
-		             for (int i = 0; i < 319; i++) {
-			             Draw_line(i, y + 90 - vid_time[1][i], DEF_DRAW_BLUE, i + 1, y + 90 - vid_time[1][i + 1],
-			                       DEF_DRAW_BLUE, 1); // Thread 1
-			             Draw_line(i, y + 90 - vid_time[0][i], DEF_DRAW_RED, i + 1, y + 90 - vid_time[0][i + 1],
-			                       DEF_DRAW_RED, 1); // Thread 0
+		             // decoding time graph of the latest 320 frames
+		             size_t decode_num = std::min<size_t>(320, vid_telemetry.decode.size());
+		             size_t present_num = std::min<size_t>(320, vid_telemetry.present.size());
+		             for (size_t i = 0; i + 1 < present_num; i++) {
+			             Draw_line(319 - i, y + 90 - vid_telemetry.present.get_recent(i).thread_ms, DEF_DRAW_BLUE,
+			                       318 - i, y + 90 - vid_telemetry.present.get_recent(i + 1).thread_ms, DEF_DRAW_BLUE,
+			                       1); // Thread 1
+		             }
+		             for (size_t i = 0; i + 1 < decode_num; i++) {
+			             Draw_line(319 - i, y + 90 - vid_telemetry.decode.get_recent(i).interval_ms, DEF_DRAW_RED,
+			                       318 - i, y + 90 - vid_telemetry.decode.get_recent(i + 1).interval_ms, DEF_DRAW_RED,
+			                       1); // Thread 0
+		             }
+		             size_t recent_num = std::min<size_t>(90, vid_telemetry.decode.size());
+		             double recent_total_time = 0;
+		             for (size_t i = 0; i < recent_num; i++) {
+			             recent_total_time += vid_telemetry.decode.get_recent(i).interval_ms;
 		             }
 
 		             Draw_line(0, y + 90, DEFAULT_TEXT_COLOR, 320, y + 90, DEFAULT_TEXT_COLOR, 2);
 		             Draw_line(0, y + 90 - vid_frametime, 0xFFFFFF00, 320, y + 90 - vid_frametime, 0xFFFFFF00, 2);
-		             if (vid_total_frames != 0 && vid_min_time != 0 && vid_recent_total_time != 0) {
+		             if (vid_total_frames != 0 && vid_min_time != 0 && recent_total_time != 0) {
 			             Draw("Avg: " + std::to_string(1000 / (vid_total_time / vid_total_frames)).substr(0, 5) +
 			                      " Min: " + std::to_string(1000 / vid_max_time).substr(0, 5) +
 			                      " Max: " + std::to_string(1000 / vid_min_time).substr(0, 5) + " Recent Avg: " +
-			                      std::to_string(1000 / (vid_recent_total_time / 90)).substr(0, 5) + " FPS",
+			                      std::to_string(1000 / (recent_total_time / recent_num)).substr(0, 5) + " FPS",
 			                  0, y + 90, 0.4, 0.4, DEFAULT_TEXT_COLOR);
 		             }
 
@@ -309,9 +350,11 @@ void VideoPlayer_init(void) {
 		                  0.4, DEF_DRAW_BLUE);
 		             Draw("Data copy 1 : " + std::to_string(vid_copy_time[1]).substr(0, 5) + "ms", 160, y + 120, 0.4,
 		                  0.4, DEF_DRAW_BLUE);
-		             Draw("Thread 0 : " + std::to_string(vid_time[0][319]).substr(0, 6) + "ms", 0, y + 130, 0.5, 0.5,
+		             double thread0_time = decode_num ? vid_telemetry.decode.get_recent(0).interval_ms : 0;
+		             double thread1_time = present_num ? vid_telemetry.present.get_recent(0).thread_ms : 0;
+		             Draw("Thread 0 : " + std::to_string(thread0_time).substr(0, 6) + "ms", 0, y + 130, 0.5, 0.5,
 		                  DEF_DRAW_RED);
-		             Draw("Thread 1 : " + std::to_string(vid_time[1][319]).substr(0, 6) + "ms", 160, y + 130, 0.5, 0.5,
+		             Draw("Thread 1 : " + std::to_string(thread1_time).substr(0, 6) + "ms", 160, y + 130, 0.5, 0.5,
 		                  DEF_DRAW_BLUE);
 		             Draw("Zoom : x" + std::to_string(vid_zoom).substr(0, 5) + " X : " + std::to_string((int)vid_x) +
 		                      " Y : " + std::to_string((int)vid_y),
@@ -515,6 +558,8 @@ void VideoPlayer_init(void) {
 		    threadCreate(convert_thread, (void *)(""), DEF_STACKSIZE, DEF_THREAD_PRIORITY_NORMAL, 0, false);
 		livestream_initer_thread = threadCreate(livestream_initer_thread_func, &network_decoder, DEF_STACKSIZE,
 		                                        DEF_THREAD_PRIORITY_NORMAL, 2, false);
+		demux_thread =
+		    threadCreate(demux_thread_func, &network_decoder, DEF_STACKSIZE, DEF_THREAD_PRIORITY_NORMAL, 0, false);
 	} else {
 		bool frame_cores[4] = {true, true, false, false};
 		bool slice_cores[4] = {false, true, false, false};
@@ -527,6 +572,8 @@ void VideoPlayer_init(void) {
 		    threadCreate(convert_thread, (void *)(""), DEF_STACKSIZE, DEF_THREAD_PRIORITY_NORMAL, 0, false);
 		livestream_initer_thread = threadCreate(livestream_initer_thread_func, &network_decoder, DEF_STACKSIZE,
 		                                        DEF_THREAD_PRIORITY_NORMAL, 1, false);
+		demux_thread =
+		    threadCreate(demux_thread_func, &network_decoder, DEF_STACKSIZE, DEF_THREAD_PRIORITY_NORMAL, 0, false);
 	}
 	stream_downloader_thread = threadCreate(network_downloader_thread, &stream_downloader, DEF_STACKSIZE,
 	                                        DEF_THREAD_PRIORITY_NORMAL, 0, false);
@@ -535,21 +582,15 @@ void VideoPlayer_init(void) {
 	vid_total_frames = 0;
 	vid_min_time = 99999999;
 	vid_max_time = 0;
-	vid_recent_total_time = 0;
-	for (int i = 0; i < 90; i++) {
-		vid_recent_time[i] = 0;
-	}
+	vid_late_frames = 0;
+	vid_dropped_frames = 0;
+	vid_telemetry.clear(var_video_telemetry_export);
 
 	for (int i = 0; i < 2; i++) {
 		vid_tex_width[i] = 0;
 		vid_tex_height[i] = 0;
 	}
 
-	for (int i = 0; i < 320; i++) {
-		vid_time[0][i] = 0;
-		vid_time[1][i] = 0;
-	}
-
 	vid_audio_time = 0;
 	vid_video_time = 0;
 	vid_copy_time[0] = 0;
@@ -622,18 +663,27 @@ void VideoPlayer_exit(void) {
 	vid_play_request = false;
 
 	stream_downloader.request_thread_exit();
-	network_decoder.interrupt = true;
+	network_decoder.request_interrupt();
 	network_decoder.request_thread_exit();
 	logger.info(DEF_SAPP0_EXIT_STR, "threadJoin()...", threadJoin(vid_decode_thread, time_out));
 	logger.info(DEF_SAPP0_EXIT_STR, "threadJoin()...", threadJoin(vid_convert_thread, time_out));
 	logger.info(DEF_SAPP0_EXIT_STR, "threadJoin()...", threadJoin(stream_downloader_thread, time_out));
 	logger.info(DEF_SAPP0_EXIT_STR, "threadJoin()...", threadJoin(livestream_initer_thread, time_out));
+	logger.info(DEF_SAPP0_EXIT_STR, "threadJoin()...", threadJoin(demux_thread, time_out));
 	threadFree(vid_decode_thread);
 	threadFree(vid_convert_thread);
 	threadFree(stream_downloader_thread);
 	threadFree(livestream_initer_thread);
+	threadFree(demux_thread);
 	stream_downloader.delete_all();
 
+	PlayerTelemetry::Session *telemetry_session = vid_telemetry.take_session();
+	if (telemetry_session) {
+		result = telemetry_session->export_csv();
+		logger.info(DEF_SAPP0_EXIT_STR, "telemetry export..." + result.string + result.error_description, result.code);
+		delete telemetry_session;
+	}
+
 	small_resource_lock.lock();
 
 	// clean up views
@@ -1364,7 +1414,7 @@ static void load_video_page(void *arg) {
 
 		vid_change_video_request = true;
 		if (network_decoder.ready) {
-			network_decoder.interrupt = true;
+			network_decoder.request_interrupt();
 		}
 
 		thumbnail_cancel_request(cur_playing_video_view->thumbnail_handle);
@@ -1459,7 +1509,7 @@ static void load_video_page(void *arg) {
 				seek_at_init_request = vid_current_pos;
 				vid_change_video_request = true;
 				if (network_decoder.ready) {
-					network_decoder.interrupt = true;
+					network_decoder.request_interrupt();
 				}
 			}
 			var_video_quality = audio_only_mode ? 0 : video_p_value;
@@ -1769,7 +1819,7 @@ static void send_seek_request_wo_lock(double pos) {
 	vid_current_pos = pos;
 	vid_seek_request = true;
 	if (network_decoder.ready) { // avoid locking while initing
-		network_decoder.interrupt = true;
+		network_decoder.request_interrupt();
 	}
 }
 static void send_seek_request(double pos) {
@@ -1962,6 +2012,18 @@ void video_draw_top_screen() {
 	}
 }
 
+// formatting and writing the csv takes hundreds of ms, so it's done on the async task thread instead of delaying the
+// start of the next video
+// `arg` is the PlayerTelemetry::Session of a finished session taken from vid_telemetry, deleted here
+static void export_telemetry(void *arg) {
+	PlayerTelemetry::Session *session = (PlayerTelemetry::Session *)arg;
+	Result_with_string result = session->export_csv();
+	if (result.code != 0) {
+		logger.error("telemetry", "export failed : " + result.error_description, result.code);
+	}
+	delete session;
+}
+
 static void decode_thread(void *arg) {
 	logger.info(DEF_SAPP0_DECODE_THREAD_STR, "Thread started.");
 
@@ -1976,6 +2038,10 @@ static void decode_thread(void *arg) {
 	TickCounter counter0, counter1;
 	osTickCounterStart(&counter0);
 	osTickCounterStart(&counter1);
+	// accumulated since the previous video frame, for the telemetry
+	double demux_time = 0;
+	double audio_decode_time = 0;
+	u64 last_downloaded_bytes = 0;
 
 	while (vid_thread_run) {
 		if (vid_play_request || vid_change_video_request) {
@@ -1999,21 +2065,31 @@ static void decode_thread(void *arg) {
 			vid_total_frames = 0;
 			vid_min_time = 99999999;
 			vid_max_time = 0;
-			vid_recent_total_time = 0;
-			for (int i = 0; i < 90; i++) {
-				vid_recent_time[i] = 0;
+			vid_late_frames = 0;
+			vid_dropped_frames = 0;
+			// the previous session ends here : its records are handed over to the export as the next session starts
+			// appending right away
+			PlayerTelemetry::Session *telemetry_session = vid_telemetry.take_session();
+			if (telemetry_session && (telemetry_session->decode.size() || telemetry_session->present.size())) {
+				if (is_async_task_running(export_telemetry)) {
+					logger.warning(DEF_SAPP0_DECODE_THREAD_STR, "telemetry export still running, session skipped");
+					delete telemetry_session;
+				} else {
+					queue_async_task(export_telemetry, telemetry_session);
+				}
+			} else {
+				delete telemetry_session;
 			}
+			vid_telemetry.clear(var_video_telemetry_export);
+			demux_time = 0;
+			audio_decode_time = 0;
+			last_downloaded_bytes = stream_downloader.get_downloaded_bytes();
 
 			for (int i = 0; i < 2; i++) {
 				vid_tex_width[i] = 0;
 				vid_tex_height[i] = 0;
 			}
 
-			for (int i = 0; i < 320; i++) {
-				vid_time[0][i] = 0;
-				vid_time[1][i] = 0;
-			}
-
 			vid_audio_time = 0;
 			vid_video_time = 0;
 			vid_copy_time[0] = 0;
@@ -2072,7 +2148,14 @@ static void decode_thread(void *arg) {
 					vid_audio_format = tmp.format_name;
 					vid_duration = tmp.duration;
 				}
-				Util_speaker_init(0, ch, vid_sample_rate);
+				result = Util_speaker_init(0, ch, vid_sample_rate);
+				if (result.code != 0) {
+					Util_err_set_error_message(result.string, result.error_description, DEF_SAPP0_DECODE_THREAD_STR,
+					                           result.code);
+					Util_err_set_error_show_flag(true);
+					var_need_refresh = true;
+					vid_play_request = false;
+				}
 				{
 					auto tmp = network_decoder.get_video_info();
 					vid_width = vid_width_org = tmp.width;
@@ -2108,7 +2191,6 @@ static void decode_thread(void *arg) {
 						small_resource_lock.lock();
 						double seek_pos_bak = vid_seek_pos;
 						vid_seek_request = false;
-						network_decoder.interrupt = false;
 						small_resource_lock.unlock();
 
 						result = network_decoder.seek(seek_pos_bak * 1000 * 1000); // nano seconds
@@ -2138,7 +2220,10 @@ static void decode_thread(void *arg) {
 				}
 				vid_duration = network_decoder.get_duration();
 
+				osTickCounterUpdate(&counter0);
 				auto type = network_decoder.next_decode_type();
+				osTickCounterUpdate(&counter0);
+				demux_time += osTickCounterRead(&counter0);
 
 				if (type == NetworkMultipleDecoder::PacketType::EoF) {
 					vid_pausing = true;
@@ -2173,23 +2258,31 @@ static void decode_thread(void *arg) {
 					double pos;
 					u8 *audio = NULL;
 					osTickCounterUpdate(&counter0);
-					result = network_decoder.decode_audio(&audio_size, &audio, &pos);
-					osTickCounterUpdate(&counter0);
-					vid_audio_time = osTickCounterRead(&counter0);
-
-					if (result.code == 0) {
-						while (true) {
-							result = Util_speaker_add_buffer(0, ch, audio, audio_size, pos);
-							if (result.code == 0 || !vid_play_request || vid_seek_request || vid_change_video_request) {
+					// decoded directly into the speaker's buffer ring
+					result = network_decoder.decode_audio(&audio_size, &audio, &pos, [&](int size) {
+						u8 *res;
+						if (!Util_speaker_can_get_buffer(0, size)) { // waiting would never help : drop the frame
+							logger.error(DEF_SAPP0_DECODE_THREAD_STR,
+							             "no room for " + std::to_string(size) + " bytes in the speaker ring");
+							return (u8 *)NULL;
+						}
+						while (!(res = Util_speaker_get_buffer(0, size))) {
+							if (!vid_play_request || vid_seek_request || vid_change_video_request) {
 								break;
 							}
-							// Util_log_save(DEF_SAPP0_DECODE_THREAD_STR, "audio queue full");
-
 							usleep(10000);
 						}
-						free(audio);
+						return res;
+					});
+					osTickCounterUpdate(&counter0);
+					vid_audio_time = osTickCounterRead(&counter0);
+					audio_decode_time += vid_audio_time;
+
+					if (result.code == 0) {
+						result = Util_speaker_add_buffer(0, ch, audio, audio_size, pos);
 						audio = NULL;
-					} else if (result.code != DEF_ERR_NEED_MORE_INPUT) { // ignore NEED_MORE_INPUT error
+					} else if (result.code != DEF_ERR_NEED_MORE_INPUT &&
+					           result.code != DEF_ERR_NEED_MORE_OUTPUT) { // ignore NEED_MORE_INPUT/OUTPUT error
 						logger.error(DEF_SAPP0_DECODE_THREAD_STR,
 						             "Util_audio_decoder_decode()..." + result.string + result.error_description,
 						             result.code);
@@ -2216,16 +2309,22 @@ static void decode_thread(void *arg) {
 					vid_max_time = std::max(vid_max_time, cur_frame_internval);
 					vid_total_time += cur_frame_internval;
 					vid_total_frames++;
-					vid_recent_time[89] = cur_frame_internval;
-					vid_recent_total_time = std::accumulate(vid_recent_time, vid_recent_time + 90, 0.0);
-					for (int i = 1; i < 90; i++) {
-						vid_recent_time[i - 1] = vid_recent_time[i];
-					}
 
-					vid_time[0][319] = cur_frame_internval;
-					for (int i = 1; i < 320; i++) {
-						vid_time[0][i - 1] = vid_time[0][i];
-					}
+					PlayerTelemetry::DecodeRecord record;
+					auto depth = network_decoder.get_packet_queue_depth();
+					u64 downloaded_bytes = stream_downloader.get_downloaded_bytes();
+					record.time = vid_telemetry.get_session_time();
+					record.interval_ms = cur_frame_internval;
+					record.demux_ms = demux_time;
+					record.video_decode_ms = vid_video_time;
+					record.audio_decode_ms = audio_decode_time;
+					record.video_queue = depth.video;
+					record.audio_queue = depth.audio;
+					record.network_bytes = downloaded_bytes - last_downloaded_bytes;
+					vid_telemetry.push(record);
+					demux_time = 0;
+					audio_decode_time = 0;
+					last_downloaded_bytes = downloaded_bytes;
 
 					if (vid_play_request && !vid_seek_request && !vid_change_video_request) {
 						if (result.code != 0 && result.code != DEF_ERR_NEED_MORE_INPUT) {
@@ -2289,6 +2388,7 @@ static void convert_thread(void *arg) {
 	while (vid_thread_run) {
 		if (vid_play_request && !vid_seek_request && !vid_change_video_request) {
 			network_decoder_critical_lock.lock();
+			double last_drawn_pts = -1;
 			while (vid_play_request && !vid_seek_request && !vid_change_video_request) {
 				double pts;
 				do {
@@ -2328,16 +2428,47 @@ static void convert_thread(void *arg) {
 					break;
 				}
 
-				bool video_need_free = false;
 				vid_copy_time[0] = osTickCounterRead(&counter0);
 
+				PlayerTelemetry::PresentRecord record;
+				record.time = vid_telemetry.get_session_time();
+				record.pts = pts;
+				record.convert_ms = record.upload_ms = record.thread_ms = 0;
+				record.dropped = false;
+
+				// late-frame policy : frames already behind the audio clock are thrown away without being converted
+				// and, if it keeps getting worse, the decoder is asked to skip non-reference frames until caught up
+				{
+					double cur_sound_pos = Util_speaker_get_current_timestamp(0, vid_sample_rate);
+					double lag = cur_sound_pos < 0 ? 0 : cur_sound_pos - pts;
+					record.av_offset_ms = lag * 1000;
+					if (lag > DECODER_SKIP_ON_THRESHOLD) {
+						network_decoder.set_skip_non_ref_frames(true);
+					} else if (lag < DECODER_SKIP_OFF_THRESHOLD) {
+						network_decoder.set_skip_non_ref_frames(false);
+					}
+					if (lag > LATE_FRAME_THRESHOLD) {
+						vid_late_frames++;
+						if (last_drawn_pts >= 0 && std::fabs(pts - last_drawn_pts) < LATE_FRAME_MAX_DRAW_INTERVAL) {
+							vid_dropped_frames++;
+							vid_current_pos = pts;
+							record.dropped = true;
+							vid_telemetry.push(record);
+							video = NULL;
+							yuv_video = NULL;
+							continue;
+						}
+					}
+				}
+
 				osTickCounterUpdate(&counter0);
 				if (!network_decoder.hw_decoder_enabled) {
-					result = Util_converter_y2r_yuv420p_to_bgr565(yuv_video, &video, vid_width, vid_height, false);
-					video_need_free = true;
+					// converted into one of the decoder's preallocated buffers straight from the decoded frame
+					result = network_decoder.convert_decoded_video_frame(vid_width, vid_height, &video);
 				}
 				osTickCounterUpdate(&counter0);
 				vid_convert_time = osTickCounterRead(&counter0);
+				record.convert_ms = vid_convert_time;
 
 				double cur_convert_time = 0;
 
@@ -2365,6 +2496,7 @@ static void convert_thread(void *arg) {
 						}
 					}
 					vid_current_pos = pts;
+					last_drawn_pts = pts;
 
 					osTickCounterUpdate(&counter0);
 					osTickCounterUpdate(&counter1);
@@ -2383,7 +2515,8 @@ static void convert_thread(void *arg) {
 					}
 
 					osTickCounterUpdate(&counter0);
-					vid_copy_time[1] += osTickCounterRead(&counter0);
+					record.upload_ms = osTickCounterRead(&counter0);
+					vid_copy_time[1] += record.upload_ms;
 
 					var_need_refresh = true;
 				} else {
@@ -2392,19 +2525,13 @@ static void convert_thread(void *arg) {
 					             result.code);
 				}
 
-				if (video_need_free) {
-					free(video);
-				}
-				video = NULL;
-				yuv_video = NULL; // this is the result of network_decoder.get_decoded_video_frame(), so it should
-				                  // not be freed
+				video = NULL; // owned by network_decoder, so it should not be freed
+				yuv_video = NULL;
 
 				osTickCounterUpdate(&counter1);
 				cur_convert_time += osTickCounterRead(&counter1);
-				vid_time[1][319] = cur_convert_time;
-				for (int i = 1; i < 320; i++) {
-					vid_time[1][i - 1] = vid_time[1][i];
-				}
+				record.thread_ms = cur_convert_time;
+				vid_telemetry.push(record);
 			}
 			network_decoder_critical_lock.unlock();
 		} else {
@@ -1,17 +1,17 @@
 #include "headers.hpp"
 
-static Mutex resource_lock;
+Mutex linear_heap_lock;
 
 void *linearAlloc_concurrent(size_t size) {
-	resource_lock.lock();
+	linear_heap_lock.lock();
 	void *res = linearAlloc(size);
-	resource_lock.unlock();
+	linear_heap_lock.unlock();
 	return res;
 }
 void linearFree_concurrent(void *ptr) {
-	resource_lock.lock();
+	linear_heap_lock.lock();
 	linearFree(ptr);
-	resource_lock.unlock();
+	linear_heap_lock.unlock();
 }
 
 void my_assert(bool condition) {
@@ -19,4 +19,27 @@ class Mutex {
 	void unlock() { LightLock_Unlock(&mutex_); }
 };
 
+// held by linearAlloc_concurrent() and linearFree_concurrent(), library calls that allocate from the linear heap (e.g.
+// C3D_TexInit()) should also be made with this locked
+extern Mutex linear_heap_lock;
+
+// auto-reset event : a signal wakes up one waiting thread, or is kept until the next wait() if nobody is waiting
+class Event {
+  private:
+	LightEvent event_;
+
+  public:
+	Event() { LightEvent_Init(&event_, RESET_ONESHOT); }
+	// non-copiable, non-movable because the memory address of `event_` must never change
+	Event(const Event &) = delete;
+	Event &operator=(const Event &) = delete;
+	Event(const Event &&) = delete;
+	Event &operator=(const Event &&) = delete;
+
+	void signal() { LightEvent_Signal(&event_); }
+	void wait() { LightEvent_Wait(&event_); }
+	// returns false if it timed out
+	bool wait(s64 timeout_ns) { return LightEvent_WaitTimeout(&event_, timeout_ns) == 0; }
+};
+
 void my_assert(bool condition); // causes a data abort
@@ -1,11 +1,43 @@
 #include "headers.hpp"
 
 #define BUFFER_SIZE 180
+#define RING_SIZE (512 * 1024) // PCM bytes that can be queued at once per channel (about 3 seconds of 44.1kHz stereo)
+#define RING_SIZE_MIN (64 * 1024) // the ring is shrunk down to this size if linear memory is short
+#define RING_ALIGN 0x80
 
 ndspWaveBuf util_ndsp_buffer[24][BUFFER_SIZE];
 double util_ndsp_buffer_timestamp[24][BUFFER_SIZE]; // {pts, sample rate}
 
-void Util_speaker_init(int play_ch, int music_ch, int sample_rate) {
+// the wave buffers are queued in the order of their indices (mod BUFFER_SIZE), and ndsp consumes them in that order,
+// so the queued ones are always util_ndsp_buffer[play_ch][tail, head)
+// their data is allocated from a linear memory ring in the same order
+static u8 *util_ndsp_ring[24];
+static u32 util_ndsp_ring_size[24];
+static u32 util_ndsp_ring_offset[24][BUFFER_SIZE]; // the offset of the data of each wave buffer in the ring
+static volatile u32 util_ndsp_head[24];            // total number of queued wave buffers
+static volatile u32 util_ndsp_tail[24];            // total number of wave buffers known to be done
+static u32 util_ndsp_ring_write[24];               // the offset to which the next data is written
+static u32 util_ndsp_ring_reserved[24];            // the size of the last area returned by Util_speaker_get_buffer()
+
+// release the wave buffers that finished playing
+static void update_tail(int play_ch) {
+	while (util_ndsp_tail[play_ch] != util_ndsp_head[play_ch] &&
+	       util_ndsp_buffer[play_ch][util_ndsp_tail[play_ch] % BUFFER_SIZE].status == NDSP_WBUF_DONE) {
+		util_ndsp_tail[play_ch]++;
+	}
+}
+static void reset_ring(int play_ch) {
+	util_ndsp_head[play_ch] = util_ndsp_tail[play_ch] = 0;
+	util_ndsp_ring_write[play_ch] = 0;
+	util_ndsp_ring_reserved[play_ch] = 0;
+	for (int i = 0; i < BUFFER_SIZE; i++) {
+		util_ndsp_buffer[play_ch][i].status = NDSP_WBUF_FREE;
+		util_ndsp_buffer_timestamp[play_ch][i] = 0.0;
+	}
+}
+
+Result_with_string Util_speaker_init(int play_ch, int music_ch, int sample_rate) {
+	Result_with_string result;
 	float mix[12] = {
 	    1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
 	};
@@ -27,41 +59,102 @@ void Util_speaker_init(int play_ch, int music_ch, int sample_rate) {
 	for (int i = 0; i < BUFFER_SIZE; i++) {
 		util_ndsp_buffer[play_ch][i].data_vaddr = NULL;
 	}
+	if (!util_ndsp_ring[play_ch]) {
+		for (u32 size = RING_SIZE; size >= RING_SIZE_MIN; size /= 2) {
+			util_ndsp_ring[play_ch] = (u8 *)linearAlloc_concurrent(size);
+			if (util_ndsp_ring[play_ch]) {
+				util_ndsp_ring_size[play_ch] = size;
+				if (size != RING_SIZE) {
+					logger.warning("speaker", "buffer ring shrunk to " + std::to_string(size / 1024) + " KiB");
+				}
+				break;
+			}
+		}
+		if (!util_ndsp_ring[play_ch]) {
+			logger.error("speaker", "failed to allocate the buffer ring");
+			result.code = DEF_ERR_OUT_OF_LINEAR_MEMORY;
+			result.string = DEF_ERR_OUT_OF_LINEAR_MEMORY_STR;
+			result.error_description = "speaker buffer ring";
+		}
+	}
+	reset_ring(play_ch);
+	return result;
 }
 
-Result_with_string Util_speaker_add_buffer(int play_ch, int music_ch, u8 *buffer, int size, double pts) {
-	Result_with_string result;
-	int free_queue = -1;
+static u32 ring_align_up(u32 offset) { return (offset + RING_ALIGN - 1) / RING_ALIGN * RING_ALIGN; }
 
-	for (int i = 0; i < BUFFER_SIZE; i++) {
-		if (util_ndsp_buffer[play_ch][i].status == NDSP_WBUF_FREE ||
-		    util_ndsp_buffer[play_ch][i].status == NDSP_WBUF_DONE) {
-			free_queue = i;
-			break;
-		}
-	}
+bool Util_speaker_can_get_buffer(int play_ch, int size) {
+	return util_ndsp_ring[play_ch] && size > 0 && (u32)size <= util_ndsp_ring_size[play_ch] / 2;
+}
 
-	if (free_queue == -1) {
-		result.code = DEF_ERR_OTHER;
-		result.string = "[Error] Queues are full ";
-		return result;
+u8 *Util_speaker_get_buffer(int play_ch, int size) {
+	if (!Util_speaker_can_get_buffer(play_ch, size)) {
+		return NULL;
+	}
+	update_tail(play_ch);
+	u32 head = util_ndsp_head[play_ch];
+	u32 tail = util_ndsp_tail[play_ch];
+	if (head - tail >= BUFFER_SIZE) {
+		return NULL;
 	}
 
-	linearFree_concurrent((void *)util_ndsp_buffer[play_ch][free_queue].data_vaddr);
-	util_ndsp_buffer[play_ch][free_queue].data_vaddr = NULL;
-	util_ndsp_buffer[play_ch][free_queue].data_vaddr = (u8 *)linearAlloc_concurrent(size * music_ch);
-	if (util_ndsp_buffer[play_ch][free_queue].data_vaddr == NULL) {
-		result.code = DEF_ERR_OUT_OF_LINEAR_MEMORY;
-		result.string = DEF_ERR_OUT_OF_LINEAR_MEMORY_STR;
-		return result;
+	u32 write = util_ndsp_ring_write[play_ch];
+	u32 offset;
+	if (head == tail) { // nothing is queued
+		offset = 0;
+	} else {
+		// the aligned end of the new data (the next write offset) must stay strictly below the read offset,
+		// otherwise write == read would make the full ring look empty
+		u32 read = util_ndsp_ring_offset[play_ch][tail % BUFFER_SIZE];
+		if (write >= read) {
+			if (write + size <= util_ndsp_ring_size[play_ch]) {
+				offset = write;
+			} else if (ring_align_up(size) < read) { // wrap around
+				offset = 0;
+			} else {
+				return NULL;
+			}
+		} else if (ring_align_up(write + size) < read) {
+			offset = write;
+		} else {
+			return NULL;
+		}
 	}
+	util_ndsp_ring_write[play_ch] = offset;
+	util_ndsp_ring_reserved[play_ch] = size;
+	return util_ndsp_ring[play_ch] + offset;
+}
 
-	memcpy((void *)util_ndsp_buffer[play_ch][free_queue].data_vaddr, buffer, size * music_ch);
+Result_with_string Util_speaker_add_buffer(int play_ch, int music_ch, u8 *buffer, int size, double pts) {
+	Result_with_string result;
 
-	util_ndsp_buffer[play_ch][free_queue].nsamples = size / 2;
-	ndspChnWaveBufAdd(play_ch, &util_ndsp_buffer[play_ch][free_queue]);
+	u8 *dst = NULL;
+	u32 write = util_ndsp_ring_write[play_ch];
+	if (util_ndsp_ring[play_ch] && buffer == util_ndsp_ring[play_ch] + write &&
+	    (u32)(size * music_ch) <= util_ndsp_ring_reserved[play_ch]) {
+		dst = buffer; // already written by the caller
+	} else {
+		dst = Util_speaker_get_buffer(play_ch, size * music_ch);
+		if (!dst) {
+			result.code = DEF_ERR_OTHER;
+			result.string = "[Error] Queues are full ";
+			return result;
+		}
+		memcpy(dst, buffer, size * music_ch);
+		write = util_ndsp_ring_write[play_ch];
+	}
+	util_ndsp_ring_reserved[play_ch] = 0;
+	util_ndsp_ring_write[play_ch] = ring_align_up(write + size * music_ch);
+	DSP_FlushDataCache(dst, size * music_ch);
+
+	u32 slot = util_ndsp_head[play_ch] % BUFFER_SIZE;
+	util_ndsp_ring_offset[play_ch][slot] = write;
+	util_ndsp_buffer_timestamp[play_ch][slot] = pts;
+	util_ndsp_buffer[play_ch][slot].data_vaddr = dst;
+	util_ndsp_buffer[play_ch][slot].nsamples = size / 2;
+	util_ndsp_head[play_ch]++;
+	ndspChnWaveBufAdd(play_ch, &util_ndsp_buffer[play_ch][slot]);
 
-	util_ndsp_buffer_timestamp[play_ch][free_queue] = pts;
 	return result;
 }
 
@@ -69,18 +162,17 @@ double Util_speaker_get_current_timestamp(int play_ch, int sample_rate) {
 	if (!Util_speaker_is_playing(play_ch)) {
 		return -1;
 	}
-	double queued_min = INFINITY;
-	for (int i = 0; i < BUFFER_SIZE; i++) {
-		if (util_ndsp_buffer[play_ch][i].status == NDSP_WBUF_PLAYING) {
-			return util_ndsp_buffer_timestamp[play_ch][i] + (double)ndspChnGetSamplePos(play_ch) / sample_rate;
+	// the first wave buffer not done yet is the one playing (or about to be played)
+	u32 head = util_ndsp_head[play_ch];
+	for (u32 i = util_ndsp_tail[play_ch]; i != head; i++) {
+		int slot = i % BUFFER_SIZE;
+		if (util_ndsp_buffer[play_ch][slot].status == NDSP_WBUF_PLAYING) {
+			return util_ndsp_buffer_timestamp[play_ch][slot] + (double)ndspChnGetSamplePos(play_ch) / sample_rate;
 		}
-		if (util_ndsp_buffer[play_ch][i].status == NDSP_WBUF_QUEUED) {
-			queued_min = std::min(queued_min, util_ndsp_buffer_timestamp[play_ch][i]);
+		if (util_ndsp_buffer[play_ch][slot].status == NDSP_WBUF_QUEUED) {
+			return util_ndsp_buffer_timestamp[play_ch][slot];
 		}
 	}
-	if (queued_min != INFINITY) {
-		return queued_min;
-	}
 	// weired...
 	if (!Util_speaker_is_playing(play_ch)) {
 		return -1;
@@ -95,10 +187,7 @@ void Util_speaker_clear_buffer(int play_ch) {
 	while (Util_speaker_is_playing(play_ch)) {
 		usleep(10000);
 	}
-	for (int i = 0; i < BUFFER_SIZE; i++) {
-		util_ndsp_buffer[play_ch][i].status = NDSP_WBUF_FREE;
-		util_ndsp_buffer_timestamp[play_ch][i] = 0.0;
-	}
+	reset_ring(play_ch);
 }
 
 void Util_speaker_pause(int play_ch) { ndspChnSetPaused(play_ch, true); }
@@ -113,7 +202,9 @@ void Util_speaker_exit(int play_ch) {
 	ndspChnWaveBufClear(play_ch);
 	ndspChnSetPaused(play_ch, false);
 	for (int i = 0; i < BUFFER_SIZE; i++) {
-		linearFree_concurrent((void *)util_ndsp_buffer[play_ch][i].data_vaddr);
 		util_ndsp_buffer[play_ch][i].data_vaddr = NULL;
 	}
+	reset_ring(play_ch);
+	linearFree_concurrent(util_ndsp_ring[play_ch]);
+	util_ndsp_ring[play_ch] = NULL;
 }
@@ -1,7 +1,15 @@
 #pragma once
 #include "types.hpp"
 
-void Util_speaker_init(int play_ch, int music_ch, int sample_rate);
+// fails if no buffer ring could be allocated for `play_ch`
+Result_with_string Util_speaker_init(int play_ch, int music_ch, int sample_rate);
+
+// whether Util_speaker_get_buffer(play_ch, size) can ever succeed (there's a ring and `size` fits in it)
+bool Util_speaker_can_get_buffer(int play_ch, int size);
+
+// returns an area of `size` bytes in the linear memory ring of `play_ch` (NULL if the queue is full)
+// if it's filled and passed to Util_speaker_add_buffer() before the next call, the data is queued without copying
+u8 *Util_speaker_get_buffer(int play_ch, int size);
 
 Result_with_string Util_speaker_add_buffer(int play_ch, int music_ch, u8 *buffer, int size, double pts);
 
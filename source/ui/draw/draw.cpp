@@ -54,6 +54,16 @@ int Draw_convert_to_pos(int height, int width, int img_height, int img_width, in
 	return pos * pixel_size;
 }
 
+void Draw_c2d_image_set_subtex(Image_data *c2d_image, int width, int height) {
+	c2d_image->subtex->width = (u16)width;
+	c2d_image->subtex->height = (u16)height;
+	c2d_image->subtex->left = 0.0;
+	c2d_image->subtex->top = 1.0;
+	c2d_image->subtex->right = width / (float)c2d_image->c2d.tex->width;
+	c2d_image->subtex->bottom = 1.0 - height / (float)c2d_image->c2d.tex->height;
+	c2d_image->c2d.subtex = c2d_image->subtex;
+}
+
 Result_with_string Draw_set_texture_data(Image_data *c2d_image, u8 *buf, int pic_width, int pic_height, int tex_size_x,
                                          int tex_size_y, GPU_TEXCOLOR color_format) {
 	return Draw_set_texture_data(c2d_image, buf, pic_width, pic_height, 0, 0, tex_size_x, tex_size_y, color_format);
@@ -117,13 +127,7 @@ Result_with_string Draw_set_texture_data(Image_data *c2d_image, u8 *buf, int pic
 		x_max = tex_size_x;
 	}
 
-	c2d_image->subtex->width = (u16)x_max;
-	c2d_image->subtex->height = (u16)y_max;
-	c2d_image->subtex->left = 0.0;
-	c2d_image->subtex->top = 1.0;
-	c2d_image->subtex->right = x_max / (float)tex_size_x;
-	c2d_image->subtex->bottom = 1.0 - y_max / (float)tex_size_y;
-	c2d_image->c2d.subtex = c2d_image->subtex;
+	Draw_c2d_image_set_subtex(c2d_image, x_max, y_max);
 
 	if (pixel_size == 2) {
 		for (int k = 0; k < y_max; k++) {
@@ -189,7 +193,10 @@ Result_with_string Draw_c2d_image_init(Image_data *c2d_image, int tex_size_x, in
 	}
 	c2d_image->c2d.subtex = c2d_image->subtex;
 
-	if (!C3D_TexInit(c2d_image->c2d.tex, (u16)tex_size_x, (u16)tex_size_y, color_format)) {
+	linear_heap_lock.lock();
+	bool tex_inited = C3D_TexInit(c2d_image->c2d.tex, (u16)tex_size_x, (u16)tex_size_y, color_format);
+	linear_heap_lock.unlock();
+	if (!tex_inited) {
 		result.code = DEF_ERR_OUT_OF_LINEAR_MEMORY;
 		result.string = DEF_ERR_OUT_OF_LINEAR_MEMORY_STR;
 		return result;
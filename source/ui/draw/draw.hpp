@@ -14,6 +14,9 @@ Result_with_string Draw_set_texture_data(Image_data *c2d_image, u8 *buf, int pic
 
 void Draw_c2d_image_set_filter(Image_data *c2d_image, bool filter);
 
+// makes the region [0, width) x [0, height) of the texture the one to be drawn
+void Draw_c2d_image_set_subtex(Image_data *c2d_image, int width, int height);
+
 Result_with_string Draw_c2d_image_init(Image_data *c2d_image, int tex_size_x, int tex_size_y,
                                        GPU_TEXCOLOR color_format);
 
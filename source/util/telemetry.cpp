@@ -0,0 +1,79 @@
+#include "headers.hpp"
+#include "telemetry.hpp"
+
+#define TELEMETRY_DIR (DEF_MAIN_DIR + "telemetry/")
+
+void PlayerTelemetry::clear(bool keep_session) {
+	decode.clear();
+	present.clear();
+	if (keep_session) {
+		if (!session) {
+			session = new Session();
+		}
+		session->decode.clear();
+		session->present.clear();
+	} else {
+		delete session;
+		session = NULL;
+	}
+	start_time = osGetTime();
+}
+float PlayerTelemetry::get_session_time() { return (osGetTime() - start_time) / 1000.0; }
+void PlayerTelemetry::push(const DecodeRecord &record) {
+	decode.push(record);
+	if (session) {
+		session->decode.push(record);
+	}
+}
+void PlayerTelemetry::push(const PresentRecord &record) {
+	present.push(record);
+	if (session) {
+		session->present.push(record);
+	}
+}
+PlayerTelemetry::Session *PlayerTelemetry::take_session() {
+	Session *res = session;
+	session = NULL;
+	return res;
+}
+
+Result_with_string PlayerTelemetry::Session::export_csv() {
+	Result_with_string result;
+	if (!decode.size() && !present.size()) {
+		return result;
+	}
+
+	char buf[0x100];
+	snprintf(buf, sizeof(buf), "%04d%02d%02d_%02d%02d%02d", var_years, var_months, var_days, var_hours, var_minutes,
+	         var_seconds);
+	std::string prefix = TELEMETRY_DIR + buf;
+
+	std::string data = "time,interval_ms,demux_ms,video_decode_ms,audio_decode_ms,video_queue,audio_queue,"
+	                   "network_bytes\n";
+	data.reserve(decode.size() * 64);
+	for (size_t i = 0; i < decode.size(); i++) {
+		const DecodeRecord &record = decode[i];
+		snprintf(buf, sizeof(buf), "%.3f,%.2f,%.2f,%.2f,%.2f,%u,%u,%lu\n", record.time, record.interval_ms,
+		         record.demux_ms, record.video_decode_ms, record.audio_decode_ms, record.video_queue,
+		         record.audio_queue, (unsigned long)record.network_bytes);
+		data += buf;
+	}
+	result = Path(prefix + "_decode.csv").write_file((const u8 *)data.data(), data.size());
+	if (result.code != 0) {
+		return result;
+	}
+
+	data = "time,pts,convert_ms,upload_ms,thread_ms,av_offset_ms,dropped\n";
+	for (size_t i = 0; i < present.size(); i++) {
+		const PresentRecord &record = present[i];
+		snprintf(buf, sizeof(buf), "%.3f,%.3f,%.2f,%.2f,%.2f,%.2f,%d\n", record.time, record.pts, record.convert_ms,
+		         record.upload_ms, record.thread_ms, record.av_offset_ms, (int)record.dropped);
+		data += buf;
+	}
+	result = Path(prefix + "_present.csv").write_file((const u8 *)data.data(), data.size());
+	if (result.code == 0) {
+		logger.info("telemetry", "exported " + std::to_string(decode.size()) + "/" + std::to_string(present.size()) +
+		                             " records to " + prefix);
+	}
+	return result;
+}
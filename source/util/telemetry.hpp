@@ -0,0 +1,90 @@
+#pragma once
+#include <algorithm>
+#include <string>
+#include <3ds.h>
+#include "types.hpp"
+
+// fixed-size ring of records : appending is O(1) and overwrites the oldest record once full
+// only one thread may append, other threads may read (a record being overwritten can be read torn, which is
+// acceptable as records are only used for statistics)
+template <typename T, size_t N> class TelemetryRing {
+	T records[N];
+	volatile u32 head = 0; // total number of appended records
+
+  public:
+	static constexpr size_t CAPACITY = N;
+
+	void push(const T &record) {
+		records[head % N] = record;
+		head = head + 1;
+	}
+	void clear() { head = 0; }
+	size_t size() const { return std::min<size_t>(head, N); }
+	// the i-th oldest record, i < size()
+	const T &operator[](size_t i) const { return records[(head - size() + i) % N]; }
+	// the i-th newest record (0 : the newest), i < size()
+	const T &get_recent(size_t i) const { return records[(head - 1 - i) % N]; }
+};
+
+// per-frame performance records of the video player
+// the latest RECENT_RECORD_NUM frames are always kept (for the graphs of the player), the whole session (up to its last
+// SESSION_RECORD_NUM frames, about 460 KB) only when it's going to be exported
+class PlayerTelemetry {
+  public:
+	static constexpr size_t RECENT_RECORD_NUM = 512;
+	static constexpr size_t SESSION_RECORD_NUM = 8192;
+
+	// appended by the decoding thread for each decoded video packet
+	// times spent on the audio packets and waiting for packets since the previous record are accumulated into it
+	struct DecodeRecord {
+		float time;            // seconds since the session started
+		float interval_ms;     // since the previous record
+		float demux_ms;        // waiting in next_decode_type()
+		float video_decode_ms; // including the wait for room in the raw frame buffer
+		float audio_decode_ms;
+		u16 video_queue; // packet queue depths
+		u16 audio_queue;
+		u32 network_bytes; // downloaded since the previous record
+	};
+	// appended by the convert thread for each video frame (drawn or dropped)
+	struct PresentRecord {
+		float time;
+		float pts;
+		float convert_ms;
+		float upload_ms;
+		float thread_ms;    // the whole work of the convert thread for the frame, excluding the sleep
+		float av_offset_ms; // positive if the video is behind the audio
+		bool dropped;
+	};
+	// the records of a whole session
+	struct Session {
+		TelemetryRing<DecodeRecord, SESSION_RECORD_NUM> decode;
+		TelemetryRing<PresentRecord, SESSION_RECORD_NUM> present;
+
+		// writes the records to DEF_MAIN_DIR "telemetry/<date>_{decode,present}.csv" (does nothing if there's no
+		// record)
+		Result_with_string export_csv();
+	};
+	TelemetryRing<DecodeRecord, RECENT_RECORD_NUM> decode;
+	TelemetryRing<PresentRecord, RECENT_RECORD_NUM> present;
+
+	PlayerTelemetry() = default;
+	PlayerTelemetry(const PlayerTelemetry &) = delete;
+	PlayerTelemetry &operator=(const PlayerTelemetry &) = delete;
+	~PlayerTelemetry() { delete session; }
+
+	// starts a new session, whose records are kept as a whole only if `keep_session` is set
+	// should not be called while records are being appended
+	void clear(bool keep_session);
+	float get_session_time();
+	void push(const DecodeRecord &record);
+	void push(const PresentRecord &record);
+	// hands over the records of the session (NULL if they are not kept), which should be deleted by the caller
+	// the records appended after this are not kept until the next clear()
+	// should not be called while records are being appended
+	Session *take_session();
+
+  private:
+	Session *session = NULL;
+	u64 start_time = 0; // osGetTime() at clear()
+};
@@ -17,9 +17,11 @@ bool var_show_fps = false;
 bool var_full_screen_mode = false;
 bool var_full_dislike_like_count = false;
 bool var_video_show_debug_info = false;
+bool var_video_telemetry_export = false;
 int var_player_response = 0; // 0 : Android, 1 : Android VR, 2 : visionOS
 bool var_video_linear_filter = true;
 double var_forward_buffer_ratio = 0.8;
+int var_prefetch_window = 3;
 u8 var_wifi_state = 0;
 u8 var_wifi_signal = 0;
 u8 var_battery_charge = 0;
@@ -17,9 +17,11 @@ extern bool var_show_fps;
 extern bool var_full_dislike_like_count;
 extern bool var_full_screen_mode;
 extern bool var_video_show_debug_info;
+extern bool var_video_telemetry_export; // dump the player telemetry to the SD card at the end of each session
 extern int var_player_response;
 extern bool var_video_linear_filter;
 extern double var_forward_buffer_ratio;
+extern int var_prefetch_window; // number of blocks requested concurrently per stream
 extern u8 var_wifi_state;
 extern u8 var_wifi_signal;
 extern u8 var_battery_charge;
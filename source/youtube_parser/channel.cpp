@@ -1,7 +1,18 @@
-#include <regex>
+#include <algorithm>
 #include "internal_common.hpp"
 #include "parser.hpp"
 
+// the renderers read from the `browse` responses
+static const JsonFilter browse_response_filter(
+    {"avatarViewModel", "backstageImageRenderer", "backstagePostRenderer", "backstagePostThreadRenderer",
+     "c4TabbedHeaderRenderer", "channelMetadataRenderer", "channelSubMenuRenderer", "chipCloudChipRenderer",
+     "compactPlaylistRenderer", "compactVideoRenderer", "contentMetadataViewModel", "continuationItemRenderer",
+     "decoratedAvatarViewModel", "feedFilterChipBarRenderer", "imageBannerViewModel", "itemSectionRenderer",
+     "pageHeaderRenderer", "pageHeaderViewModel", "pollRenderer", "richGridRenderer", "richItemRenderer",
+     "sectionListRenderer", "shelfRenderer", "shortsLockupViewModel", "singleColumnBrowseResultsRenderer",
+     "tabRenderer", "twoColumnBrowseResultsRenderer", "verticalListRenderer", "videoRenderer",
+     "videoWithContextRenderer"});
+
 static RJson get_initial_data(Document &json_root, const std::string &html) {
 	RJson res;
 	if (fast_extract_initial(json_root, html, "ytInitialData", res)) {
@@ -251,7 +262,7 @@ YouTubeChannelDetail youtube_load_channel_page(std::string url_or_id) {
 		if (!result.first) {
 			debug_error((res.error = "[ch-id] " + result.second));
 		} else {
-			auto html = result.second;
+			const std::string &html = result.second;
 			if (!html.size()) {
 				res.error = "[ch-id] html empty";
 				return res;
@@ -263,13 +274,13 @@ YouTubeChannelDetail youtube_load_channel_page(std::string url_or_id) {
 		std::string &id = url_or_id;
 		res.url_original = "https://m.youtube.com/channel/" + id;
 
-		std::string post_content =
-		    R"({"context": {"client": {"hl": "%0", "gl": "%1", "clientName": "MWEB", "clientVersion": "2.20241202.07.00"}}, "browseId": "%2", "params":"EgZ2aWRlb3PyBgQKAjoA"})";
-		post_content = std::regex_replace(post_content, std::regex("%0"), language_code);
-		post_content = std::regex_replace(post_content, std::regex("%1"), country_code);
-		post_content = std::regex_replace(post_content, std::regex("%2"), id);
+		static const RequestTemplate post_content_template(
+		    R"({"context": {"client": {"hl": "%0", "gl": "%1", "clientName": "MWEB", "clientVersion": "2.20241202.07.00"}}, "browseId": "%2", "params":"EgZ2aWRlb3PyBgQKAjoA"})",
+		    3);
+		std::string post_content = post_content_template.render({language_code, country_code, id});
 
-		access_and_parse_json([&]() { return http_post_json(get_innertube_api_url("browse"), post_content); },
+		access_and_parse_json(http_post_json_request(get_innertube_api_url("browse"), post_content),
+		                      browse_response_filter,
 		                      [&](Document &, RJson json) { parse_channel_data(json, res); },
 		                      [&](const std::string &error) {
 			                      res.error = "[ch-id] " + error;
@@ -310,7 +321,7 @@ YouTubeChannelDetail youtube_load_channel_streams_page(std::string url_or_id) {
 		if (!result.first) {
 			debug_error((res.error = "[ch-streams] " + result.second));
 		} else {
-			auto html = result.second;
+			const std::string &html = result.second;
 			if (!html.size()) {
 				res.error = "[ch-streams] html empty";
 				return res;
@@ -323,13 +334,13 @@ YouTubeChannelDetail youtube_load_channel_streams_page(std::string url_or_id) {
 		std::string &id = url_or_id;
 		res.url_original = "https://m.youtube.com/channel/" + id;
 
-		std::string post_content =
-		    R"({"context": {"client": {"hl": "%0", "gl": "%1", "clientName": "MWEB", "clientVersion": "2.20241202.07.00"}}, "browseId": "%2", "params":"EgdzdHJlYW1z8gYECgJ6AA%3D%3D"})";
-		post_content = std::regex_replace(post_content, std::regex("%0"), language_code);
-		post_content = std::regex_replace(post_content, std::regex("%1"), country_code);
-		post_content = std::regex_replace(post_content, std::regex("%2"), id);
+		static const RequestTemplate post_content_template(
+		    R"({"context": {"client": {"hl": "%0", "gl": "%1", "clientName": "MWEB", "clientVersion": "2.20241202.07.00"}}, "browseId": "%2", "params":"EgdzdHJlYW1z8gYECgJ6AA%3D%3D"})",
+		    3);
+		std::string post_content = post_content_template.render({language_code, country_code, id});
 
-		access_and_parse_json([&]() { return http_post_json(get_innertube_api_url("browse"), post_content); },
+		access_and_parse_json(http_post_json_request(get_innertube_api_url("browse"), post_content),
+		                      browse_response_filter,
 		                      [&](Document &, RJson json) {
 			                      parse_channel_data(json, res);
 			                      res.streams_loaded = true;
@@ -373,7 +384,7 @@ YouTubeChannelDetail youtube_load_channel_shorts_page(std::string url_or_id) {
 		if (!result.first) {
 			debug_error((res.error = "[ch-shorts] " + result.second));
 		} else {
-			auto html = result.second;
+			const std::string &html = result.second;
 			if (!html.size()) {
 				res.error = "[ch-shorts] html empty";
 				return res;
@@ -387,13 +398,13 @@ YouTubeChannelDetail youtube_load_channel_shorts_page(std::string url_or_id) {
 		std::string &id = url_or_id;
 		res.url_original = "https://m.youtube.com/channel/" + id;
 
-		std::string post_content =
-		    R"({"context": {"client": {"hl": "%0", "gl": "%1", "clientName": "MWEB", "clientVersion": "2.20241202.07.00"}}, "browseId": "%2", "params":"EgZzaG9ydHPyBgUKA5oBAA%3D%3D"})";
-		post_content = std::regex_replace(post_content, std::regex("%0"), language_code);
-		post_content = std::regex_replace(post_content, std::regex("%1"), country_code);
-		post_content = std::regex_replace(post_content, std::regex("%2"), id);
+		static const RequestTemplate post_content_template(
+		    R"({"context": {"client": {"hl": "%0", "gl": "%1", "clientName": "MWEB", "clientVersion": "2.20241202.07.00"}}, "browseId": "%2", "params":"EgZzaG9ydHPyBgUKA5oBAA%3D%3D"})",
+		    3);
+		std::string post_content = post_content_template.render({language_code, country_code, id});
 
-		access_and_parse_json([&]() { return http_post_json(get_innertube_api_url("browse"), post_content); },
+		access_and_parse_json(http_post_json_request(get_innertube_api_url("browse"), post_content),
+		                      browse_response_filter,
 		                      [&](Document &, RJson json) {
 			                      parse_channel_data(json, res);
 			                      res.shorts_loaded = true;
@@ -416,11 +427,10 @@ std::vector<YouTubeChannelDetail> youtube_load_channel_page_multi(std::vector<st
 	int n = ids.size();
 	int finished = 0;
 	for (int i = 0; i < n; i++) {
-		std::string post_content =
-		    R"({"context": {"client": {"hl": "%0", "gl": "%1", "clientName": "MWEB", "clientVersion": "2.20241202.07.00"}}, "browseId": "%2", "params":"EgZ2aWRlb3PyBgQKAjoA"})";
-		post_content = std::regex_replace(post_content, std::regex("%0"), language_code);
-		post_content = std::regex_replace(post_content, std::regex("%1"), country_code);
-		post_content = std::regex_replace(post_content, std::regex("%2"), ids[i]);
+		static const RequestTemplate post_content_template(
+		    R"({"context": {"client": {"hl": "%0", "gl": "%1", "clientName": "MWEB", "clientVersion": "2.20241202.07.00"}}, "browseId": "%2", "params":"EgZ2aWRlb3PyBgQKAjoA"})",
+		    3);
+		std::string post_content = post_content_template.render({language_code, country_code, ids[i]});
 		requests.push_back(http_post_json_request(get_innertube_api_url("browse"), post_content)
 		                       .with_on_finish_callback([&](NetworkResult &, int cur) {
 			                       if (progress) {
@@ -431,16 +441,17 @@ std::vector<YouTubeChannelDetail> youtube_load_channel_page_multi(std::vector<st
 	debug_info("access(multi)...");
 	auto results = thread_network_session_list.perform(requests);
 	debug_info("ok");
-	for (auto result : results) {
-		result.data.push_back('\0');
+	for (auto &result : results) {
+		result.data.push_back('\0'); // the receiver keeps room for it, so it's never reallocated
 		YouTubeChannelDetail cur_res;
-		parse_json_destructive((char *)&result.data[0],
+		parse_json_destructive((char *)result.data.data(), browse_response_filter,
 		                       [&](Document &, RJson data) { parse_channel_data(data, cur_res); },
 		                       [&](const std::string &error) {
 			                       cur_res.error = "[ch-mul] " + error;
 			                       debug_error(cur_res.error);
 		                       });
-		res.push_back(cur_res);
+		std::vector<u8>().swap(result.data); // the strings in cur_res are copies, so the response is not needed anymore
+		res.push_back(std::move(cur_res));
 	}
 	return res;
 }
@@ -451,14 +462,14 @@ void YouTubeChannelDetail::load_more_videos() {
 		return;
 	}
 
-	std::string post_content =
-	    R"({"context": {"client": {"hl": "%0", "gl": "%1", "clientName": "MWEB", "clientVersion": "2.20241202.07.00", "utcOffsetMinutes": 0}, "request": {}, "user": {}}, "continuation": ")" +
-	    videos_continue_token + "\"}";
-	post_content = std::regex_replace(post_content, std::regex("%0"), language_code);
-	post_content = std::regex_replace(post_content, std::regex("%1"), country_code);
+	static const RequestTemplate post_content_template(
+	    R"({"context": {"client": {"hl": "%0", "gl": "%1", "clientName": "MWEB", "clientVersion": "2.20241202.07.00", "utcOffsetMinutes": 0}, "request": {}, "user": {}}, "continuation": "%2"})",
+	    3);
+	std::string post_content = post_content_template.render({language_code, country_code, videos_continue_token});
 
 	access_and_parse_json(
-	    [&]() { return http_post_json(get_innertube_api_url("browse"), post_content); },
+	    http_post_json_request(get_innertube_api_url("browse"), post_content),
+	    browse_response_filter,
 	    [&](Document &, RJson yt_result) {
 		    videos_continue_token = "";
 
@@ -493,14 +504,14 @@ void YouTubeChannelDetail::load_more_streams() {
 		return;
 	}
 
-	std::string post_content =
-	    R"({"context": {"client": {"hl": "%0", "gl": "%1", "clientName": "MWEB", "clientVersion": "2.20241202.07.00", "utcOffsetMinutes": 0}, "request": {}, "user": {}}, "continuation": ")" +
-	    streams_continue_token + "\"}";
-	post_content = std::regex_replace(post_content, std::regex("%0"), language_code);
-	post_content = std::regex_replace(post_content, std::regex("%1"), country_code);
+	static const RequestTemplate post_content_template(
+	    R"({"context": {"client": {"hl": "%0", "gl": "%1", "clientName": "MWEB", "clientVersion": "2.20241202.07.00", "utcOffsetMinutes": 0}, "request": {}, "user": {}}, "continuation": "%2"})",
+	    3);
+	std::string post_content = post_content_template.render({language_code, country_code, streams_continue_token});
 
 	access_and_parse_json(
-	    [&]() { return http_post_json(get_innertube_api_url("browse"), post_content); },
+	    http_post_json_request(get_innertube_api_url("browse"), post_content),
+	    browse_response_filter,
 	    [&](Document &, RJson yt_result) {
 		    streams_continue_token = "";
 
@@ -533,14 +544,14 @@ void YouTubeChannelDetail::load_more_shorts() {
 		return;
 	}
 
-	std::string post_content =
-	    R"({"context": {"client": {"hl": "%0", "gl": "%1", "clientName": "MWEB", "clientVersion": "2.20241202.07.00", "utcOffsetMinutes": 0}, "request": {}, "user": {}}, "continuation": ")" +
-	    shorts_continue_token + "\"}";
-	post_content = std::regex_replace(post_content, std::regex("%0"), language_code);
-	post_content = std::regex_replace(post_content, std::regex("%1"), country_code);
+	static const RequestTemplate post_content_template(
+	    R"({"context": {"client": {"hl": "%0", "gl": "%1", "clientName": "MWEB", "clientVersion": "2.20241202.07.00", "utcOffsetMinutes": 0}, "request": {}, "user": {}}, "continuation": "%2"})",
+	    3);
+	std::string post_content = post_content_template.render({language_code, country_code, shorts_continue_token});
 
 	access_and_parse_json(
-	    [&]() { return http_post_json(get_innertube_api_url("browse"), post_content); },
+	    http_post_json_request(get_innertube_api_url("browse"), post_content),
+	    browse_response_filter,
 	    [&](Document &, RJson yt_result) {
 		    shorts_continue_token = "";
 		    for (auto i : yt_result["onResponseReceivedActions"].array_items()) {
@@ -703,14 +714,14 @@ void YouTubeChannelDetail::load_playlists() {
 		return;
 	}
 
+	static const RequestTemplate post_content_template(
+	    R"({"context": {"client": {"hl": "%0", "gl": "%1", "clientName": "MWEB", "clientVersion": "2.20241202.07.00", "utcOffsetMinutes": 0}}, "browseId": "%2", "params": "%3"})",
+	    4);
 	std::string post_content =
-	    R"({"context": {"client": {"hl": "%0", "gl": "%1", "clientName": "MWEB", "clientVersion": "2.20241202.07.00", "utcOffsetMinutes": 0}}, "browseId": "%2", "params": "%3"})";
-	post_content = std::regex_replace(post_content, std::regex("%0"), language_code);
-	post_content = std::regex_replace(post_content, std::regex("%1"), country_code);
-	post_content = std::regex_replace(post_content, std::regex("%2"), playlist_tab_browse_id);
-	post_content = std::regex_replace(post_content, std::regex("%3"), playlist_tab_params);
+	    post_content_template.render({language_code, country_code, playlist_tab_browse_id, playlist_tab_params});
 
-	access_and_parse_json([&]() { return http_post_json(get_innertube_api_url("browse"), post_content); },
+	access_and_parse_json(http_post_json_request(get_innertube_api_url("browse"), post_content),
+	                      browse_response_filter,
 	                      [&](Document &, RJson json) { channel_load_playlists_(json, *this); },
 	                      [&](const std::string &error) { debug_error((this->error = "[ch/pl] " + error)); });
 }
@@ -766,7 +777,7 @@ void YouTubeChannelDetail::load_more_community_posts() {
 		if (!result.first) {
 			debug_error((this->error = "[ch/c+] " + result.second));
 		} else {
-			auto html = result.second;
+			const std::string &html = result.second;
 			if (!html.size()) {
 				error = "failed to download community page";
 				return;
@@ -783,13 +794,14 @@ void YouTubeChannelDetail::load_more_community_posts() {
 			load_community_items(contents, *this);
 		}
 	} else {
+		static const RequestTemplate post_content_template(
+		    R"({"context": {"client": {"hl": "%0", "gl": "%1", "clientName": "WEB", "clientVersion": "2.20241126.01.00", "utcOffsetMinutes": 0}}, "continuation": "%2"})",
+		    3);
 		std::string post_content =
-		    R"({"context": {"client": {"hl": "%0", "gl": "%1", "clientName": "WEB", "clientVersion": "2.20241126.01.00", "utcOffsetMinutes": 0}}, "continuation": "%2"})";
-		post_content = std::regex_replace(post_content, std::regex("%0"), language_code);
-		post_content = std::regex_replace(post_content, std::regex("%1"), country_code);
-		post_content = std::regex_replace(post_content, std::regex("%2"), community_continuation_token);
+		    post_content_template.render({language_code, country_code, community_continuation_token});
 
-		access_and_parse_json([&]() { return http_post_json(get_innertube_api_url("browse"), post_content); },
+		access_and_parse_json(http_post_json_request(get_innertube_api_url("browse"), post_content),
+		                      browse_response_filter,
 		                      [&](Document &, RJson yt_result) {
 			                      RJson contents;
 			                      for (auto i : yt_result["onResponseReceivedEndpoints"].array_items()) {
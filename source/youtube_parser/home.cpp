@@ -1,8 +1,12 @@
-#include <regex>
 #include "internal_common.hpp"
 #include "parser.hpp"
 #include "../oauth/oauth.hpp"
 
+// the renderers read from the `browse` responses of the home feed
+static const JsonFilter home_response_filter(
+    {"compactVideoRenderer", "elementRenderer", "itemSectionRenderer", "sectionListRenderer", "shelfRenderer",
+     "singleColumnBrowseResultsRenderer", "tabRenderer", "verticalListRenderer"});
+
 YouTubeHomeResult youtube_load_home_page() {
 	YouTubeHomeResult res;
 
@@ -12,17 +16,14 @@ YouTubeHomeResult youtube_load_home_page() {
 
 	std::string browse_id = OAuth::is_authenticated() ? "FEwhat_to_watch" : "FEhype_leaderboard";
 
-	std::string post_content;
-	if (OAuth::is_authenticated()) {
-		post_content =
-		    R"({"context": {"client": {"hl": "$0", "gl": "$1", "clientName": "ANDROID_VR", "clientVersion": "1.65.10", "deviceMake": "Oculus", "deviceModel": "Quest 3", "osName": "Android", "osVersion": "14", "androidSdkVersion": "34"}}, "browseId": "$2"})";
-	} else {
-		post_content =
-		    R"({"context": {"client": {"hl": "$0", "gl": "$1", "clientName": "ANDROID", "clientVersion": "19.51.37", "osName": "Android", "osVersion": "14", "androidSdkVersion": "34"}}, "browseId": "$2"})";
-	}
-	post_content = std::regex_replace(post_content, std::regex("\\$0"), language_code);
-	post_content = std::regex_replace(post_content, std::regex("\\$1"), country_code);
-	post_content = std::regex_replace(post_content, std::regex("\\$2"), browse_id);
+	static const RequestTemplate android_vr_template(
+	    R"({"context": {"client": {"hl": "$0", "gl": "$1", "clientName": "ANDROID_VR", "clientVersion": "1.65.10", "deviceMake": "Oculus", "deviceModel": "Quest 3", "osName": "Android", "osVersion": "14", "androidSdkVersion": "34"}}, "browseId": "$2"})",
+	    3, '$');
+	static const RequestTemplate android_template(
+	    R"({"context": {"client": {"hl": "$0", "gl": "$1", "clientName": "ANDROID", "clientVersion": "19.51.37", "osName": "Android", "osVersion": "14", "androidSdkVersion": "34"}}, "browseId": "$2"})",
+	    3, '$');
+	const RequestTemplate &post_content_template = OAuth::is_authenticated() ? android_vr_template : android_template;
+	std::string post_content = post_content_template.render({language_code, country_code, browse_id});
 
 	std::map<std::string, std::string> headers;
 	if (OAuth::is_authenticated()) {
@@ -30,7 +31,8 @@ YouTubeHomeResult youtube_load_home_page() {
 	}
 
 	access_and_parse_json(
-	    [&]() { return http_post_json(get_innertube_api_url("browse"), post_content, headers); },
+	    http_post_json_request(get_innertube_api_url("browse"), post_content, headers),
+	    home_response_filter,
 	    [&](Document &json_root, RJson yt_result) {
 		    res.visitor_data = yt_result["responseContext"]["visitorData"].string_value();
 
@@ -140,19 +142,16 @@ void YouTubeHomeResult::load_more_results() {
 		return;
 	}
 
-	std::string post_content;
-	if (OAuth::is_authenticated()) {
-		post_content =
-		    R"({"context": {"client": {"hl": "$0", "gl": "$1", "clientName": "ANDROID_VR", "clientVersion": "1.65.10", "deviceMake": "Oculus", "deviceModel": "Quest 3", "osName": "Android", "osVersion": "14", "androidSdkVersion": "34", "visitorData": "$2"}}, "continuation": "$3"})";
-	} else {
-		// Kept for future feature implementation. Currently unused as unauthenticated requests return early.
-		post_content =
-		    R"({"context": {"client": {"hl": "$0", "gl": "$1", "clientName": "MWEB", "clientVersion": "2.20241202.07.00", "visitorData": "$2"}}, "continuation": "$3"})";
-	}
-	post_content = std::regex_replace(post_content, std::regex("\\$0"), language_code);
-	post_content = std::regex_replace(post_content, std::regex("\\$1"), country_code);
-	post_content = std::regex_replace(post_content, std::regex("\\$2"), visitor_data);
-	post_content = std::regex_replace(post_content, std::regex("\\$3"), continue_token);
+	static const RequestTemplate android_vr_template(
+	    R"({"context": {"client": {"hl": "$0", "gl": "$1", "clientName": "ANDROID_VR", "clientVersion": "1.65.10", "deviceMake": "Oculus", "deviceModel": "Quest 3", "osName": "Android", "osVersion": "14", "androidSdkVersion": "34", "visitorData": "$2"}}, "continuation": "$3"})",
+	    4, '$');
+	// Kept for future feature implementation. Currently unused as unauthenticated requests return early.
+	static const RequestTemplate mweb_template(
+	    R"({"context": {"client": {"hl": "$0", "gl": "$1", "clientName": "MWEB", "clientVersion": "2.20241202.07.00", "visitorData": "$2"}}, "continuation": "$3"})",
+	    4, '$');
+	const RequestTemplate &post_content_template = OAuth::is_authenticated() ? android_vr_template : mweb_template;
+	std::string post_content =
+	    post_content_template.render({language_code, country_code, visitor_data, continue_token});
 
 	continue_token = "";
 
@@ -162,7 +161,8 @@ void YouTubeHomeResult::load_more_results() {
 	}
 
 	access_and_parse_json(
-	    [&]() { return http_post_json(get_innertube_api_url("browse"), post_content, headers); },
+	    http_post_json_request(get_innertube_api_url("browse"), post_content, headers),
+	    home_response_filter,
 	    [&](Document &json_root, RJson yt_result) {
 		    if (yt_result["responseContext"]["visitorData"].string_value() != "") {
 			    visitor_data = yt_result["responseContext"]["visitorData"].string_value();
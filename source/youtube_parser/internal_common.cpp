@@ -23,6 +23,36 @@ namespace youtube_parser {
 std::string language_code = "en";
 std::string country_code = "US";
 
+RequestTemplate::RequestTemplate(const std::string &text, int arg_num, char marker) {
+	literals.push_back("");
+	for (size_t i = 0; i < text.size(); i++) {
+		if (text[i] == marker && i + 1 < text.size() && text[i + 1] >= '0' && text[i + 1] < '0' + arg_num) {
+			arg_indices.push_back(text[++i] - '0');
+			literals.push_back("");
+		} else {
+			literals.back().push_back(text[i]);
+			literals_len++;
+		}
+	}
+}
+std::string RequestTemplate::render(std::initializer_list<std::string> args) const {
+	const std::string *arg_begin = args.begin();
+	size_t len = literals_len;
+	for (auto index : arg_indices) {
+		len += index < (int)args.size() ? arg_begin[index].size() : 0;
+	}
+	std::string res;
+	res.reserve(len);
+	res += literals[0];
+	for (size_t i = 0; i < arg_indices.size(); i++) {
+		if (arg_indices[i] < (int)args.size()) {
+			res += arg_begin[arg_indices[i]];
+		}
+		res += literals[i + 1];
+	}
+	return res;
+}
+
 static bool thread_network_session_list_inited = false;
 NetworkSessionList thread_network_session_list;
 static void confirm_thread_network_session_list_inited() {
@@ -62,17 +92,16 @@ HttpRequest http_post_json_request(const std::string &url, const std::string &js
 	return HttpRequest::POST(url, headers, json);
 }
 
-std::pair<bool, std::string> http_post_json(const std::string &url, const std::string &json,
-                                            std::map<std::string, std::string> headers) {
-	debug_info("accessing(POST)...");
-	auto result = thread_network_session_list.perform(http_post_json_request(url, json, headers));
+NetworkResult perform_json_request(const HttpRequest &request) {
+	debug_info(request.method == "POST" ? "accessing(POST)..." : "accessing...");
+	NetworkResult result = thread_network_session_list.perform(request);
 	if (result.fail) {
 		debug_error("fail : " + result.error);
-		return {false, result.error};
 	} else {
 		debug_info("ok");
-		return {true, std::string(result.data.begin(), result.data.end())};
+		result.data.push_back('\0'); // the receiver keeps room for it
 	}
+	return result;
 }
 
 bool starts_with(const std::string &str, const std::string &pattern, size_t offset) {
@@ -337,6 +366,190 @@ RJson get_succeeding_json_regexes(Document &json_root, const std::string &html,
 	return RJson();
 }
 
+// keys never read by the parser that hold large subtrees, sorted
+static const char *UNREAD_KEYS[] = {
+    "adPlacements", "adSlots", "annotations", "attestation", "clickTrackingParams",
+    "endscreen", "frameworkUpdates", "heartbeatParams", "loggingContext", "loggingDirectives",
+    "microformat", "playbackTracking", "playerAds", "storyboards", "trackingParams",
+};
+// strcmp() between `str` and the key of length `len`
+static int compare_key(const char *str, const char *key, size_t len) {
+	int res = strncmp(str, key, len);
+	return res ? res : (str[len] ? 1 : 0);
+}
+static bool key_ends_with(const char *key, size_t len, const char *suffix, size_t suffix_len) {
+	return len >= suffix_len && !memcmp(key + len - suffix_len, suffix, suffix_len);
+}
+static bool is_renderer_key(const char *key, size_t len) {
+	return key_ends_with(key, len, "Renderer", 8) || key_ends_with(key, len, "ViewModel", 9);
+}
+bool JsonFilter::is_skipped(const char *key, size_t len) const {
+	if (is_renderer_key(key, len)) {
+		return !renderers.count(std::string(key, len));
+	}
+	auto unread_keys_end = UNREAD_KEYS + sizeof(UNREAD_KEYS) / sizeof(UNREAD_KEYS[0]);
+	auto itr = std::lower_bound(UNREAD_KEYS, unread_keys_end, key,
+	                            [&](const char *str, const char *) { return compare_key(str, key, len) < 0; });
+	return itr != unread_keys_end && !compare_key(*itr, key, len);
+}
+
+// opt-in (build with -DYT_PARSER_FILTER_DEBUG) as it costs memory and lookups :
+// an object whose renderers were skipped gets a member with this key listing them, so that looking one of them up
+// can be reported : a renderer read by an extractor but missing in its filter would otherwise be silently lost
+#ifdef YT_PARSER_FILTER_DEBUG
+#define SKIPPED_RENDERERS_KEY "(skipped renderers)"
+
+static Mutex warned_renderers_lock;
+static std::set<std::string> warned_renderers;
+static void warn_skipped_renderer_lookup(const rapidjson::Value &object, const char *key) {
+	if (!is_renderer_key(key, strlen(key))) {
+		return;
+	}
+	auto skipped = object.FindMember(SKIPPED_RENDERERS_KEY);
+	if (skipped == object.MemberEnd()) {
+		return;
+	}
+	for (const auto &i : skipped->value.GetArray()) {
+		if (!strcmp(i.GetString(), key)) {
+			warned_renderers_lock.lock();
+			bool first = warned_renderers.insert(key).second;
+			warned_renderers_lock.unlock();
+			if (first) {
+				debug_warning(std::string(key) + " was skipped by a json filter but is read, add it to the filter");
+			}
+			return;
+		}
+	}
+}
+#endif
+
+// SAX handler that forwards the events to a Document except for the skipped members
+class FilteringHandler {
+	struct ObjectState {
+		SizeType member_num = 0; // the number of the members kept
+#ifdef YT_PARSER_FILTER_DEBUG
+		std::vector<std::pair<const char *, SizeType>> skipped_renderers;
+#endif
+	};
+	Document &document;
+	const JsonFilter &filter;
+	std::vector<ObjectState> objects; // the open objects
+	int skip_depth = 0;               // the depth in the skipped subtree, 0 if not in it
+	bool skip_value = false;          // the next value belongs to a skipped member
+
+	// returns false if the (scalar) value should be skipped
+	bool begin_value() {
+		if (skip_depth) {
+			return false;
+		}
+		if (skip_value) {
+			skip_value = false;
+			return false;
+		}
+		return true;
+	}
+	// returns false if the object or array should be skipped
+	bool begin_container() {
+		if (skip_depth || skip_value) {
+			skip_value = false;
+			skip_depth++;
+			return false;
+		}
+		return true;
+	}
+
+  public:
+	FilteringHandler(Document &document, const JsonFilter &filter) : document(document), filter(filter) {}
+
+	bool Null() { return begin_value() ? document.Null() : true; }
+	bool Bool(bool b) { return begin_value() ? document.Bool(b) : true; }
+	bool Int(int i) { return begin_value() ? document.Int(i) : true; }
+	bool Uint(unsigned i) { return begin_value() ? document.Uint(i) : true; }
+	bool Int64(int64_t i) { return begin_value() ? document.Int64(i) : true; }
+	bool Uint64(uint64_t i) { return begin_value() ? document.Uint64(i) : true; }
+	bool Double(double d) { return begin_value() ? document.Double(d) : true; }
+	bool RawNumber(const char *str, SizeType len, bool copy) {
+		return begin_value() ? document.RawNumber(str, len, copy) : true;
+	}
+	bool String(const char *str, SizeType len, bool copy) {
+		return begin_value() ? document.String(str, len, copy) : true;
+	}
+	bool Key(const char *str, SizeType len, bool copy) {
+		if (skip_depth) {
+			return true;
+		}
+		if (filter.is_skipped(str, len)) {
+#ifdef YT_PARSER_FILTER_DEBUG
+			// in-situ parsing : the key stays valid in the parsed string
+			if (!copy && is_renderer_key(str, len)) {
+				objects.back().skipped_renderers.push_back({str, len});
+			}
+#endif
+			skip_value = true;
+			return true;
+		}
+		objects.back().member_num++;
+		return document.Key(str, len, copy);
+	}
+	bool StartObject() {
+		if (!begin_container()) {
+			return true;
+		}
+		objects.emplace_back();
+		return document.StartObject();
+	}
+	bool EndObject(SizeType) {
+		if (skip_depth) {
+			skip_depth--;
+			return true;
+		}
+		ObjectState &object = objects.back();
+#ifdef YT_PARSER_FILTER_DEBUG
+		if (object.skipped_renderers.size()) {
+			document.Key(SKIPPED_RENDERERS_KEY, strlen(SKIPPED_RENDERERS_KEY), false);
+			document.StartArray();
+			for (auto i : object.skipped_renderers) {
+				document.String(i.first, i.second, false);
+			}
+			document.EndArray(object.skipped_renderers.size());
+			object.member_num++;
+		}
+#endif
+		SizeType member_num = object.member_num;
+		objects.pop_back();
+		return document.EndObject(member_num);
+	}
+	bool StartArray() { return begin_container() ? document.StartArray() : true; }
+	bool EndArray(SizeType element_num) {
+		if (skip_depth) {
+			skip_depth--;
+			return true;
+		}
+		return document.EndArray(element_num); // elements are never skipped
+	}
+};
+
+RJson parse_json_filtered_inplace(Document &json_root, char *str, const JsonFilter &filter, std::string &error) {
+#ifdef YT_PARSER_FILTER_DEBUG
+	RJson::key_not_found_hook() = warn_skipped_renderer_lookup;
+#endif
+	InsituStringStream stream(str);
+	Reader reader;
+	ParseResult parse_result;
+	auto generator = [&](Document &document) {
+		FilteringHandler handler(document, filter);
+		parse_result = reader.Parse<kParseInsituFlag>(stream, handler);
+		return !parse_result.IsError();
+	};
+	json_root.Populate(generator);
+	if (parse_result.IsError()) {
+		error = "Parsing error " + std::to_string(parse_result.Code()) + " at " + std::to_string(parse_result.Offset());
+		return RJson();
+	}
+	error = "";
+	return RJson(json_root);
+}
+
 std::string convert_url_to_mobile(std::string url) {
 	// strip out of http:// or https://
 	{
@@ -1,5 +1,6 @@
 #include <string>
 #include <map>
+#include <set>
 #include <vector>
 #include "parser.hpp"
 #include "rapidjson_wrapper.hpp"
@@ -38,10 +39,31 @@ extern NetworkSessionList thread_network_session_list;
 HttpRequest http_get_request(const std::string &url, std::map<std::string, std::string> headers = {});
 HttpRequest http_post_json_request(const std::string &url, const std::string &json,
                                    std::map<std::string, std::string> headers = {});
+// performs `request` for a json response : unless it failed, `data` of the result is followed by a '\0' so that it
+// can be parsed in-situ, and it's never copied
+NetworkResult perform_json_request(const HttpRequest &request);
 #endif
 std::pair<bool, std::string> http_get(const std::string &url, std::map<std::string, std::string> header = {});
-std::pair<bool, std::string> http_post_json(const std::string &url, const std::string &json,
-                                            std::map<std::string, std::string> header = {});
+
+// visitor data shared by the requests (see visitor_data.cpp)
+// returns the cached one if it's fresh enough (`*cached` is set to true), otherwise fetches a new one
+std::string get_visitor_data(bool *cached = NULL);
+// fetches a new one synchronously, e.g. when the server rejected the cached one
+std::string refresh_visitor_data();
+
+// request body template with placeholders `marker` + digit (only those below `arg_num` are recognized)
+// the template is split at the placeholders once when constructed, so that rendering a body is a single pass that
+// just concatenates the pieces, unlike a chain of std::regex_replace() which builds a regex for every placeholder
+// the arguments are inserted verbatim (they are not escaped)
+class RequestTemplate {
+	std::vector<std::string> literals; // literals.size() == arg_indices.size() + 1
+	std::vector<int> arg_indices;      // the argument inserted after literals[i]
+	size_t literals_len = 0;
+
+  public:
+	RequestTemplate(const std::string &text, int arg_num, char marker = '%');
+	std::string render(std::initializer_list<std::string> args) const;
+};
 
 // string util
 bool starts_with(const std::string &str, const std::string &pattern, size_t offset = 0);
@@ -71,6 +93,21 @@ bool fast_extract_initial(Document &json_root, const std::string &html, const st
 
 RJson get_succeeding_json_regexes(Document &json_root, const std::string &html, std::vector<const char *> patterns);
 
+// the renderers an extractor reads from an InnerTube response
+// InnerTube responses are mostly made of renderers the parser never looks at, so they are parsed with the SAX api and
+// only what can be read is materialized in the DOM : a member whose key ends with "Renderer" or "ViewModel" and is
+// not in `renderers` is skipped with its whole subtree, as are the tracking/logging/ads members that are never read
+// only members are skipped, so arrays keep their lengths (a skipped renderer leaves an empty object in its array)
+class JsonFilter {
+	std::set<std::string> renderers;
+
+  public:
+	JsonFilter(std::initializer_list<const char *> renderers) : renderers(renderers.begin(), renderers.end()) {}
+	bool is_skipped(const char *key, size_t len) const;
+};
+// in-situ parsing of `str` into `json_root` with the members filtered out by `filter` skipped
+RJson parse_json_filtered_inplace(Document &json_root, char *str, const JsonFilter &filter, std::string &error);
+
 // parses `str` as json and calls `on_success` or `on_fail` based on the result of the parsing
 // the content of `str` will be modified
 template <class Func1, class Func2>
@@ -84,15 +121,37 @@ void parse_json_destructive(char *str, const Func1 &on_success, const Func2 &on_
 		on_success(json_root, data); // both `json_root` and `str` is alive at this point
 	}
 }
-// calls `access` to fetch json and calls `parse` to parse the json
+// same as above, but the members filtered out by `filter` are not in the resulting json
+template <class Func1, class Func2>
+void parse_json_destructive(char *str, const JsonFilter &filter, const Func1 &on_success, const Func2 &on_fail) {
+	std::string json_err;
+	Document json_root;
+	RJson data = parse_json_filtered_inplace(json_root, str, filter, json_err);
+	if (json_err != "") {
+		on_fail(json_err);
+	} else {
+		on_success(json_root, data);
+	}
+}
+// performs `request` and calls `on_success` or `on_fail` based on the result of the parsing of the response
 // properly handles the lifetime of json objects
-template <class Func1, class Func2, class Func3>
-void access_and_parse_json(const Func1 &access, const Func2 &on_success, const Func3 &on_fail) {
-	auto result = access();
-	if (result.first) {
-		parse_json_destructive(&result.second[0], on_success, on_fail);
+template <class Func1, class Func2>
+void access_and_parse_json(const HttpRequest &request, const Func1 &on_success, const Func2 &on_fail) {
+	NetworkResult result = perform_json_request(request);
+	if (!result.fail) {
+		parse_json_destructive((char *)result.data.data(), on_success, on_fail);
+	} else {
+		on_fail(result.error);
+	}
+}
+template <class Func1, class Func2>
+void access_and_parse_json(const HttpRequest &request, const JsonFilter &filter, const Func1 &on_success,
+                           const Func2 &on_fail) {
+	NetworkResult result = perform_json_request(request);
+	if (!result.fail) {
+		parse_json_destructive((char *)result.data.data(), filter, on_success, on_fail);
 	} else {
-		on_fail(result.second);
+		on_fail(result.error);
 	}
 }
 
@@ -84,6 +84,7 @@ struct YouTubeVideoDetail {
 	bool is_upcoming;
 	std::string playability_status;
 	std::string playability_reason;
+	bool is_age_gated = false; // the playability status is an age check
 	int stream_fragment_len; // used only for livestreams
 	std::string like_count_str;
 	std::string dislike_count_str;
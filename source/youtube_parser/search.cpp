@@ -1,7 +1,13 @@
-#include <regex>
 #include "internal_common.hpp"
 #include "parser.hpp"
 
+// the renderers read from the `search` responses
+static const JsonFilter search_response_filter(
+    {"compactChannelRenderer", "compactPlaylistRenderer", "compactRadioRenderer", "compactVideoRenderer",
+     "continuationItemRenderer", "didYouMeanRenderer", "gridShelfViewModel", "horizontalCardListRenderer",
+     "itemSectionRenderer", "reelShelfRenderer", "sectionListRenderer", "showingResultsForRenderer",
+     "videoWithContextRenderer"});
+
 static bool parse_searched_item(RJson content, std::vector<YouTubeSuccinctItem> &res) {
 	bool success = true;
 
@@ -110,14 +116,14 @@ YouTubeSearchResult youtube_load_search(std::string url) {
 	}
 	query_word = new_query_word;
 
-	std::string post_content =
-	    R"({"context": {"client": {"hl": "%0", "gl": "%1", "clientName": "MWEB", "clientVersion": "2.20241202.07.00"}}, "query": ")" +
-	    query_word + "\"}";
-	post_content = std::regex_replace(post_content, std::regex("%0"), language_code);
-	post_content = std::regex_replace(post_content, std::regex("%1"), country_code);
+	static const RequestTemplate post_content_template(
+	    R"({"context": {"client": {"hl": "%0", "gl": "%1", "clientName": "MWEB", "clientVersion": "2.20241202.07.00"}}, "query": "%2"})",
+	    3);
+	std::string post_content = post_content_template.render({language_code, country_code, query_word});
 
 	access_and_parse_json(
-	    [&]() { return http_post_json(get_innertube_api_url("search"), post_content); },
+	    http_post_json_request(get_innertube_api_url("search"), post_content),
+	    search_response_filter,
 	    [&](Document &, RJson yt_result) {
 		    if (yt_result.has_key("estimatedResults")) {
 			    res.estimated_result_num = yt_result["estimatedResults"].string_value();
@@ -178,14 +184,14 @@ void YouTubeSearchResult::load_more_results() {
 	}
 
 	// POST to get more results
-	std::string post_content =
-	    R"({"context": {"client": {"hl": "%0", "gl": "%1", "clientName": "MWEB", "clientVersion": "2.20241202.07.00", "utcOffsetMinutes": 0}, "request": {}, "user": {}}, "continuation": ")" +
-	    continue_token + "\"}";
-	post_content = std::regex_replace(post_content, std::regex("%0"), language_code);
-	post_content = std::regex_replace(post_content, std::regex("%1"), country_code);
+	static const RequestTemplate post_content_template(
+	    R"({"context": {"client": {"hl": "%0", "gl": "%1", "clientName": "MWEB", "clientVersion": "2.20241202.07.00", "utcOffsetMinutes": 0}, "request": {}, "user": {}}, "continuation": "%2"})",
+	    3);
+	std::string post_content = post_content_template.render({language_code, country_code, continue_token});
 
 	access_and_parse_json(
-	    [&]() { return http_post_json(get_innertube_api_url("search"), post_content); },
+	    http_post_json_request(get_innertube_api_url("search"), post_content),
+	    search_response_filter,
 	    [&](Document &, RJson yt_result) {
 		    estimated_result_num = yt_result["estimatedResults"].string_value();
 		    continue_token = "";
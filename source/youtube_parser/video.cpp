@@ -1,4 +1,3 @@
-#include <regex>
 #include "internal_common.hpp"
 #include "parser.hpp"
 #include <iostream>
@@ -11,9 +10,25 @@
 #include "rapidjson/prettywriter.h"
 #include "rapidjson/stringbuffer.h"
 
+// the renderers read from the `player` responses
+static const JsonFilter player_response_filter({"playerCaptionsTracklistRenderer"});
+// the renderers read from the `next` responses
+static const JsonFilter next_response_filter(
+    {"buttonRenderer", "buttonViewModel", "commentRenderer", "commentRepliesRenderer", "commentThreadRenderer",
+     "compactAutoplayRenderer", "compactPlaylistRenderer", "compactRadioRenderer", "compactVideoRenderer",
+     "continuationItemRenderer", "defaultButtonViewModel", "engagementPanelSectionListRenderer",
+     "expandableVideoDescriptionBodyRenderer", "itemSectionRenderer", "likeButtonViewModel",
+     "playlistPanelVideoRenderer", "sectionListRenderer", "segmentedLikeDislikeButtonRenderer",
+     "segmentedLikeDislikeButtonViewModel", "slimMetadataButtonRenderer", "slimMetadataToggleButtonRenderer",
+     "slimOwnerRenderer", "slimVideoDescriptionRenderer", "slimVideoInformationRenderer", "slimVideoMetadataRenderer",
+     "slimVideoMetadataSectionRenderer", "structuredDescriptionContentRenderer", "tabRenderer", "toggleButtonRenderer",
+     "toggleButtonViewModel", "videoDescriptionHeaderRenderer", "videoMetadataRenderer", "videoOwnerRenderer",
+     "videoWithContextRenderer", "watchNextTabbedResultsRenderer"});
+
 static bool extract_player_data(Document &json_root, RJson player_response, YouTubeVideoDetail &res) {
 	res.playability_status = player_response["playabilityStatus"]["status"].string_value();
 	res.playability_reason = player_response["playabilityStatus"]["reason"].string_value();
+	res.is_age_gated = player_response["playabilityStatus"].has_key("desktopLegacyAgeGateReason");
 	res.is_upcoming = player_response["videoDetails"]["isUpcoming"].bool_value();
 	res.livestream_type = player_response["videoDetails"]["isLiveContent"].bool_value()
 	                          ? YouTubeVideoDetail::LivestreamType::LIVESTREAM
@@ -113,13 +128,13 @@ static bool extract_player_data(Document &json_root, RJson player_response, YouT
 	}
 
 	// extract caption data
-	std::string captions_content =
-	    R"({"context": {"client": {"hl": "%0","gl": "%1","clientName": "MWEB","clientVersion": "2.20241202.07.00"}}, "videoId": "%2"})";
-	captions_content = std::regex_replace(captions_content, std::regex("%0"), language_code);
-	captions_content = std::regex_replace(captions_content, std::regex("%1"), country_code);
-	captions_content = std::regex_replace(captions_content, std::regex("%2"), res.id);
+	static const RequestTemplate captions_content_template(
+	    R"({"context": {"client": {"hl": "%0","gl": "%1","clientName": "MWEB","clientVersion": "2.20241202.07.00"}}, "videoId": "%2"})",
+	    3);
+	std::string captions_content = captions_content_template.render({language_code, country_code, res.id});
 
-	access_and_parse_json([&]() { return http_post_json(get_innertube_api_url("player"), captions_content); },
+	access_and_parse_json(http_post_json_request(get_innertube_api_url("player"), captions_content),
+	                      player_response_filter,
 	                      [&](Document &, RJson mweb_data) {
 		                      RJson captions = mweb_data["captions"]["playerCaptionsTracklistRenderer"];
 
@@ -483,101 +498,58 @@ static void extract_metadata(RJson data, YouTubeVideoDetail &res) {
 	}
 }
 
-static std::string extractVisitorData() {
-	std::string url = "https://www.youtube.com/sw.js_data";
-	std::map<std::string, std::string> headers = {{"Origin", "https://www.youtube.com"},
-	                                              {"Referer", "https://www.youtube.com/"}};
-	auto response = http_get(url, headers);
-
-	if (response.first) {
-		std::string json_content = response.second;
-		const std::string unwanted_prefix = ")]}'\n";
-		if (json_content.find(unwanted_prefix) == 0) {
-			json_content = json_content.substr(unwanted_prefix.size());
-		}
-
-		rapidjson::Document document;
-		std::string error;
-		RJson data = RJson::parse(document, json_content.c_str(), error);
-
-		if (data.is_valid()) {
-			std::string visitor_data = data[static_cast<size_t>(0)][static_cast<size_t>(2)][static_cast<size_t>(0)]
-			                               [static_cast<size_t>(0)][static_cast<size_t>(13)]
-			                                   .string_value();
-			logger.info("Visitor Data", "Fetched new visitor data: " + visitor_data);
-			return visitor_data;
-		} else {
-			logger.error("Visitor Data", "JSON Parsing Error: " + error);
-			return "";
-		}
-	} else {
-		logger.error("Visitor Data", "Failed to fetch visitor data");
-		return "";
-	}
-}
-
-YouTubeVideoDetail youtube_load_video_page(std::string url) {
-	YouTubeVideoDetail res;
-
-	res.id = youtube_get_video_id_by_url(url);
-	if (res.id.empty()) {
-		res.error = "Not a video URL: " + url;
-		return res;
-	}
-
-	std::string playlist_id = youtube_get_playlist_id_by_url(url);
-
-	std::string video_content;
-	std::string visitor_data = extractVisitorData();
+// fetches and parses the `next` and `player` responses into `res` (res.id should be set)
+// returns false if any of the requests failed
+static bool load_video_page(YouTubeVideoDetail &res, const std::string &playlist_id, const std::string &visitor_data) {
+	static const RequestTemplate android_vr_player_template(
+	    R"({"videoId": "%0", %1"context": {"client": {"hl": "%2","gl": "%3","clientName": "ANDROID_VR","clientVersion": "1.65.10","deviceMake": "Oculus","deviceModel": "Quest 3","androidSdkVersion": "34","osName": "Android","osVersion": "14","visitorData": "%4"}}, "playbackContext": {"contentPlaybackContext": {"signatureTimestamp": "0"}}, "contentCheckOk": true, "racyCheckOk": true})",
+	    5);
+	static const RequestTemplate android_player_template(
+	    R"({"videoId": "%0", %1"context": {"client": {"hl": "%2","gl": "%3","clientName": "ANDROID","clientVersion": "20.10.38","deviceMake": "Apple","deviceModel": "iPhone9,1","osName": "iPhone","userAgent": "com.google.ios.youtube/19.01.1 (iPhone9,1; U; CPU iOS 15_0_0 like Mac OS X;)\"","osVersion": "15.0.0.19A346", "visitorData": "%4"}}, "playbackContext": {"contentPlaybackContext": {"signatureTimestamp": "0"}}})",
+	    5);
+	static const RequestTemplate android_vr_test_player_template(
+	    R"({"videoId": "%0", %1"context": {"client": {"hl": "%2","gl": "%3","clientName": "ANDROID_VR","clientVersion": "1.65.10","deviceMake": "Oculus","deviceModel": "Quest 3","androidSdkVersion": "34","osName": "Android", "userAgent": "com.google.android.apps.youtube.vr.oculus/1.62.27 (Linux; U; Android 12L; eureka-user Build/SQ3A.220605.009.A1) gzip\"","osVersion": "12L", "visitorData": "%4"}}, "playbackContext": {"contentPlaybackContext": {"signatureTimestamp": "0"}}})",
+	    5);
+	static const RequestTemplate visionos_player_template(
+	    R"({"videoId": "%0", %1"context": {"client": {"hl": "%2","gl": "%3","clientName": "VISIONOS","clientVersion": "0.1","deviceMake": "Apple","deviceModel": "iPhone16,2","osName": "iPhone","userAgent": "com.google.ios.youtube/20.10.4 (iPhone16,2; U; CPU iOS 18_3_2 like Mac OS X;)\"","osVersion": "2.2.22N842", "visitorData": "%4"}}, "playbackContext": {"contentPlaybackContext": {"signatureTimestamp": "0"}}})",
+	    5);
+	static const RequestTemplate android_vr_next_template(
+	    R"({"videoId": "%0", %1"context": {"client": {"hl": "%2","gl": "%3","clientName": "ANDROID_VR","clientVersion": "1.65.10","deviceMake": "Oculus","deviceModel": "Quest 3","androidSdkVersion": "34","osName": "Android","osVersion": "14","visitorData": "%4"}}, "playbackContext": {"contentPlaybackContext": {"signatureTimestamp": "0"}}})",
+	    5);
+	static const RequestTemplate mweb_next_template(
+	    R"({"videoId": "%0", %1"context": {"client": {"hl": "%2","gl": "%3","clientName": "MWEB","clientVersion": "2.20241202.07.00"}}, "playbackContext": {"contentPlaybackContext": {"signatureTimestamp": "0"}}})",
+	    5);
 
 	// Use Android VR client when authenticated, regardless of var_player_response setting
 	bool use_android_vr = OAuth::is_authenticated();
 
+	const RequestTemplate *video_content_template;
 	if (use_android_vr) {
-		video_content =
-		    R"({"videoId": "%0", %1"context": {"client": {"hl": "%2","gl": "%3","clientName": "ANDROID_VR","clientVersion": "1.65.10","deviceMake": "Oculus","deviceModel": "Quest 3","androidSdkVersion": "34","osName": "Android","osVersion": "14","visitorData": "%4"}}, "playbackContext": {"contentPlaybackContext": {"signatureTimestamp": "0"}}, "contentCheckOk": true, "racyCheckOk": true})";
+		video_content_template = &android_vr_player_template;
 	} else if (var_player_response == 0) {
 		// This makes no sense, I know. But InnerTube is completely okay with it, so let's use it.
-		video_content =
-		    R"({"videoId": "%0", %1"context": {"client": {"hl": "%2","gl": "%3","clientName": "ANDROID","clientVersion": "20.10.38","deviceMake": "Apple","deviceModel": "iPhone9,1","osName": "iPhone","userAgent": "com.google.ios.youtube/19.01.1 (iPhone9,1; U; CPU iOS 15_0_0 like Mac OS X;)\"","osVersion": "15.0.0.19A346", "visitorData": "%4"}}, "playbackContext": {"contentPlaybackContext": {"signatureTimestamp": "0"}}})";
+		video_content_template = &android_player_template;
 	} else if (var_player_response == 1) {
 		// For testing. By default, Android is used.
-		video_content =
-		    R"({"videoId": "%0", %1"context": {"client": {"hl": "%2","gl": "%3","clientName": "ANDROID_VR","clientVersion": "1.65.10","deviceMake": "Oculus","deviceModel": "Quest 3","androidSdkVersion": "34","osName": "Android", "userAgent": "com.google.android.apps.youtube.vr.oculus/1.62.27 (Linux; U; Android 12L; eureka-user Build/SQ3A.220605.009.A1) gzip\"","osVersion": "12L", "visitorData": "%4"}}, "playbackContext": {"contentPlaybackContext": {"signatureTimestamp": "0"}}})";
+		video_content_template = &android_vr_test_player_template;
 	} else if (var_player_response == 2) {
 		// Unused client in InnerTube. Has some similar quirks to Android VR and iOS, but might still be useful.
 		// Yes, we identify as an iPhone in some places. This is intentional and it works. Don't ask why.
-		video_content =
-		    R"({"videoId": "%0", %1"context": {"client": {"hl": "%2","gl": "%3","clientName": "VISIONOS","clientVersion": "0.1","deviceMake": "Apple","deviceModel": "iPhone16,2","osName": "iPhone","userAgent": "com.google.ios.youtube/20.10.4 (iPhone16,2; U; CPU iOS 18_3_2 like Mac OS X;)\"","osVersion": "2.2.22N842", "visitorData": "%4"}}, "playbackContext": {"contentPlaybackContext": {"signatureTimestamp": "0"}}})";
+		video_content_template = &visionos_player_template;
 	} else {
 		// User messed with something. Fix that.
 		logger.error("appdata", "Invalid value for player_response has been set. Falling back to 0 (Android)!");
-		video_content =
-		    R"({"videoId": "%0", %1"context": {"client": {"hl": "%2","gl": "%3","clientName": "ANDROID","clientVersion": "20.10.38","deviceMake": "Apple","deviceModel": "iPhone9,1","osName": "iPhone","userAgent": "com.google.ios.youtube/19.01.1 (iPhone9,1; U; CPU iOS 15_0_0 like Mac OS X;)\"","osVersion": "15.0.0.19A346", "visitorData": "%4"}}, "playbackContext": {"contentPlaybackContext": {"signatureTimestamp": "0"}}})";
+		video_content_template = &android_player_template;
 		var_player_response = 0;
 		misc_tasks_request(TASK_SAVE_SETTINGS);
 	}
-	video_content = std::regex_replace(video_content, std::regex("%0"), res.id);
-	video_content = std::regex_replace(video_content, std::regex("%1"),
-	                                   playlist_id.empty() ? "" : "\"playlistId\": \"" + playlist_id + "\", ");
-	video_content = std::regex_replace(video_content, std::regex("%2"), language_code);
-	video_content = std::regex_replace(video_content, std::regex("%3"), country_code);
-	video_content = std::regex_replace(video_content, std::regex("%4"), visitor_data);
+	std::string playlist_fragment = playlist_id.empty() ? "" : "\"playlistId\": \"" + playlist_id + "\", ";
+	std::string video_content =
+	    video_content_template->render({res.id, playlist_fragment, language_code, country_code, visitor_data});
 
-	std::string post_content;
-	if (use_android_vr) {
-		post_content =
-		    R"({"videoId": "%0", %1"context": {"client": {"hl": "%2","gl": "%3","clientName": "ANDROID_VR","clientVersion": "1.65.10","deviceMake": "Oculus","deviceModel": "Quest 3","androidSdkVersion": "34","osName": "Android","osVersion": "14","visitorData": "%4"}}, "playbackContext": {"contentPlaybackContext": {"signatureTimestamp": "0"}}})";
-	} else {
-		post_content =
-		    R"({"videoId": "%0", %1"context": {"client": {"hl": "%2","gl": "%3","clientName": "MWEB","clientVersion": "2.20241202.07.00"}}, "playbackContext": {"contentPlaybackContext": {"signatureTimestamp": "0"}}})";
-	}
-	post_content = std::regex_replace(post_content, std::regex("%0"), res.id);
-	post_content = std::regex_replace(post_content, std::regex("%1"),
-	                                  playlist_id.empty() ? "" : "\"playlistId\": \"" + playlist_id + "\", ");
-	post_content = std::regex_replace(post_content, std::regex("%2"), language_code);
-	post_content = std::regex_replace(post_content, std::regex("%3"), country_code);
-	post_content = std::regex_replace(post_content, std::regex("%4"), visitor_data);
+	const RequestTemplate *post_content_template = use_android_vr ? &android_vr_next_template : &mweb_next_template;
+	std::string post_content =
+	    post_content_template->render({res.id, playlist_fragment, language_code, country_code, visitor_data});
 
 	std::string urls[2] = {get_innertube_api_url("next"), get_innertube_api_url("player")};
 
@@ -608,8 +580,9 @@ YouTubeVideoDetail youtube_load_video_page(std::string url) {
 	if (success) {
 		for (int i = 0; i < 2; i++) {
 			if (!results[i].data.empty()) {
-				results[i].data.push_back('\0');
-				parse_json_destructive((char *)&results[i].data[0],
+				results[i].data.push_back('\0'); // the receiver keeps room for it, so it's never reallocated
+				parse_json_destructive((char *)results[i].data.data(),
+				                       i == 0 ? next_response_filter : player_response_filter,
 				                       [&](Document &json_root, RJson data) {
 					                       if (i == 0) {
 						                       extract_metadata(data, res);
@@ -633,23 +606,14 @@ YouTubeVideoDetail youtube_load_video_page(std::string url) {
 			debug_info("Fallback to unauthenticated Android Client");
 
 			std::string fallback_content =
-			    R"({"videoId": "%0", %1"context": {"client": {"hl": "%2","gl": "%3","clientName": "ANDROID","clientVersion": "20.10.38","deviceMake": "Apple","deviceModel": "iPhone9,1","osName": "iPhone","userAgent": "com.google.ios.youtube/19.01.1 (iPhone9,1; U; CPU iOS 15_0_0 like Mac OS X;)\"","osVersion": "15.0.0.19A346", "visitorData": "%4"}}, "playbackContext": {"contentPlaybackContext": {"signatureTimestamp": "0"}}})";
-			fallback_content = std::regex_replace(fallback_content, std::regex("%0"), res.id);
-			fallback_content =
-			    std::regex_replace(fallback_content, std::regex("%1"),
-			                       playlist_id.empty() ? "" : "\"playlistId\": \"" + playlist_id + "\", ");
-			fallback_content = std::regex_replace(fallback_content, std::regex("%2"), language_code);
-			fallback_content = std::regex_replace(fallback_content, std::regex("%3"), country_code);
-			fallback_content = std::regex_replace(fallback_content, std::regex("%4"), visitor_data);
-
-			std::map<std::string, std::string> empty_headers;
-			auto fallback_result = http_post_json(get_innertube_api_url("player"), fallback_content, empty_headers);
-
-			if (fallback_result.first && !fallback_result.second.empty()) {
-				std::vector<char> fallback_data(fallback_result.second.begin(), fallback_result.second.end());
-				fallback_data.push_back('\0');
+			    android_player_template.render({res.id, playlist_fragment, language_code, country_code, visitor_data});
+
+			NetworkResult fallback_result =
+			    perform_json_request(http_post_json_request(get_innertube_api_url("player"), fallback_content));
+
+			if (!fallback_result.fail && fallback_result.data.size() > 1) { // not only the terminating '\0'
 				parse_json_destructive(
-				    (char *)&fallback_data[0],
+				    (char *)fallback_result.data.data(), player_response_filter,
 				    [&](Document &json_root, RJson data) { extract_player_data(json_root, data, res); },
 				    [&](const std::string &error) { debug_error("[v-fallback] " + error); });
 			} else {
@@ -657,6 +621,38 @@ YouTubeVideoDetail youtube_load_video_page(std::string url) {
 			}
 		}
 	}
+	return success;
+}
+
+// the status returned when the visitor data itself is distrusted ("Sign in to confirm you're not a bot")
+// the reason is localized (hl), so only the structure of the status is looked at : the age check shares the status
+// but is told apart by its own field, and the rare other cases (e.g. private videos) just cost one more request
+static bool is_visitor_data_rejected(const YouTubeVideoDetail &res) {
+	return res.playability_status == "LOGIN_REQUIRED" && !res.is_age_gated;
+}
+
+YouTubeVideoDetail youtube_load_video_page(std::string url) {
+	YouTubeVideoDetail res;
+
+	res.id = youtube_get_video_id_by_url(url);
+	if (res.id.empty()) {
+		res.error = "Not a video URL: " + url;
+		return res;
+	}
+
+	std::string playlist_id = youtube_get_playlist_id_by_url(url);
+
+	bool visitor_data_cached;
+	std::string visitor_data = get_visitor_data(&visitor_data_cached);
+	bool success = load_video_page(res, playlist_id, visitor_data);
+	// the cached visitor data may have been rejected : retry once with a new one
+	if (success && visitor_data_cached && is_visitor_data_rejected(res)) {
+		debug_caution("visitor data rejected (" + res.playability_reason + "), retrying with new visitor data");
+		std::string id = res.id;
+		res = YouTubeVideoDetail();
+		res.id = id;
+		success = load_video_page(res, playlist_id, refresh_visitor_data());
+	}
 
 	if (res.id != "") {
 		res.succinct_thumbnail_url = youtube_get_video_thumbnail_url_by_id(res.id);
@@ -687,25 +683,26 @@ void YouTubeVideoDetail::load_more_suggestions() {
 	}
 
 	// POST to get more results
-	std::string post_content;
+	static const RequestTemplate android_vr_template(
+	    R"({"context": {"client": {"hl": "%0", "gl": "%1", "clientName": "ANDROID_VR", "clientVersion": "1.65.10", "deviceMake": "Oculus", "deviceModel": "Quest 3", "androidSdkVersion": "34", "osName": "Android", "osVersion": "14"}}, "continuation": "%2"})",
+	    3);
+	static const RequestTemplate mweb_template(
+	    R"({"context": {"client": {"hl": "%0", "gl": "%1", "clientName": "MWEB", "clientVersion": "2.20241202.07.00", "utcOffsetMinutes": 0}, "request": {}, "user": {}}, "continuation": "%2"})",
+	    3);
+
+	const RequestTemplate *post_content_template = &mweb_template;
 	std::map<std::string, std::string> headers;
 
 	if (metadata_from_android_vr && OAuth::is_authenticated()) {
-		post_content =
-		    R"({"context": {"client": {"hl": "%0", "gl": "%1", "clientName": "ANDROID_VR", "clientVersion": "1.65.10", "deviceMake": "Oculus", "deviceModel": "Quest 3", "androidSdkVersion": "34", "osName": "Android", "osVersion": "14"}}, "continuation": ")" +
-		    suggestions_continue_token + "\"}";
+		post_content_template = &android_vr_template;
 		headers["Authorization"] = "Bearer " + OAuth::get_access_token();
-	} else {
-		post_content =
-		    R"({"context": {"client": {"hl": "%0", "gl": "%1", "clientName": "MWEB", "clientVersion": "2.20241202.07.00", "utcOffsetMinutes": 0}, "request": {}, "user": {}}, "continuation": ")" +
-		    suggestions_continue_token + "\"}";
 	}
-
-	post_content = std::regex_replace(post_content, std::regex("%0"), language_code);
-	post_content = std::regex_replace(post_content, std::regex("%1"), country_code);
+	std::string post_content =
+	    post_content_template->render({language_code, country_code, suggestions_continue_token});
 
 	access_and_parse_json(
-	    [&]() { return http_post_json(get_innertube_api_url("next"), post_content, headers); },
+	    http_post_json_request(get_innertube_api_url("next"), post_content, headers),
+	    next_response_filter,
 	    [&](Document &, RJson yt_result) {
 		    suggestions_continue_token = "";
 
@@ -776,11 +773,10 @@ void YouTubeVideoDetail::load_more_comments() {
 
 	if (comment_continue_type == 0) {
 		access_and_parse_json(
-		    [&]() {
-			    return http_get("https://m.youtube.com/watch_comment?action_get_comments=1&pbj=1&ctoken=" +
-			                        comment_continue_token,
-			                    {{"X-YouTube-Client-Version", "2.20210714.00.00"}, {"X-YouTube-Client-Name", "2"}});
-		    },
+		    http_get_request("https://m.youtube.com/watch_comment?action_get_comments=1&pbj=1&ctoken=" +
+		                         comment_continue_token,
+		                     {{"X-YouTube-Client-Version", "2.20210714.00.00"}, {"X-YouTube-Client-Name", "2"}}),
+		    next_response_filter,
 		    [&](Document &, RJson yt_result) {
 			    comment_continue_type = -1;
 			    comment_continue_token = "";
@@ -802,13 +798,13 @@ void YouTubeVideoDetail::load_more_comments() {
 		    },
 		    [&](const std::string &error) { debug_error((this->error = "[v-com+0] " + error)); });
 	} else {
-		std::string post_content =
-		    R"({"context": {"client": {"hl": "%0", "gl": "%1", "clientName": "MWEB", "clientVersion": "2.20241202.07.00", "utcOffsetMinutes": 0}, "request": {}, "user": {}}, "continuation": ")" +
-		    comment_continue_token + "\"}";
-		post_content = std::regex_replace(post_content, std::regex("%0"), language_code);
-		post_content = std::regex_replace(post_content, std::regex("%1"), country_code);
+		static const RequestTemplate post_content_template(
+		    R"({"context": {"client": {"hl": "%0", "gl": "%1", "clientName": "MWEB", "clientVersion": "2.20241202.07.00", "utcOffsetMinutes": 0}, "request": {}, "user": {}}, "continuation": "%2"})",
+		    3);
+		std::string post_content = post_content_template.render({language_code, country_code, comment_continue_token});
 
-		access_and_parse_json([&]() { return http_post_json(get_innertube_api_url("next"), post_content); },
+		access_and_parse_json(http_post_json_request(get_innertube_api_url("next"), post_content),
+		                      next_response_filter,
 		                      [&](Document &, RJson yt_result) {
 			                      comment_continue_type = -1;
 			                      comment_continue_token = "";
@@ -842,14 +838,14 @@ void YouTubeVideoDetail::Comment::load_more_replies() {
 		return;
 	}
 
-	std::string post_content =
-	    R"({"context": {"client": {"hl": "%0", "gl": "%1", "clientName": "MWEB", "clientVersion": "2.20241202.07.00", "utcOffsetMinutes": 0}, "request": {}, "user": {}}, "continuation": ")" +
-	    replies_continue_token + "\"}";
-	post_content = std::regex_replace(post_content, std::regex("%0"), language_code);
-	post_content = std::regex_replace(post_content, std::regex("%1"), country_code);
+	static const RequestTemplate post_content_template(
+	    R"({"context": {"client": {"hl": "%0", "gl": "%1", "clientName": "MWEB", "clientVersion": "2.20241202.07.00", "utcOffsetMinutes": 0}, "request": {}, "user": {}}, "continuation": "%2"})",
+	    3);
+	std::string post_content = post_content_template.render({language_code, country_code, replies_continue_token});
 
 	access_and_parse_json(
-	    [&]() { return http_post_json(get_innertube_api_url("next"), post_content); },
+	    http_post_json_request(get_innertube_api_url("next"), post_content),
+	    next_response_filter,
 	    [&](Document &, RJson yt_result) {
 		    replies_continue_token = "";
 		    for (auto i : yt_result["onResponseReceivedEndpoints"].array_items()) {
@@ -902,7 +898,7 @@ void YouTubeVideoDetail::load_caption(const std::string &base_lang_id, const std
 	url += "&fmt=json3&xorb=2&xobt=3&xovt=3"; // the meanings of xorb, xobt, xovt are unknown, and these three
 	                                          // parameters seem to be unnecessary
 
-	access_and_parse_json([&]() { return http_get(url); },
+	access_and_parse_json(http_get_request(url),
 	                      [&](Document &, RJson yt_result) {
 		                      std::vector<YouTubeVideoDetail::CaptionPiece> cur_caption;
 		                      for (auto caption_piece : yt_result["events"].array_items()) {
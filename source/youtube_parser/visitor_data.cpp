@@ -0,0 +1,114 @@
+#include <ctime>
+#include "internal_common.hpp"
+#include "util/async_task.hpp"
+
+// the visitor data is valid for a fairly long time, so it's shared by all the requests instead of being fetched
+// for every video page : it's kept on the SD card across launches, refreshed in the background once it gets old,
+// and only refreshed synchronously when it's too old or the server rejected it
+#define VISITOR_DATA_PATH (DEF_MAIN_DIR + "visitor_data.txt")
+#define VISITOR_DATA_TTL (24 * 60 * 60)        // in seconds, older data is never used
+#define VISITOR_DATA_REFRESH_AGE (6 * 60 * 60) // in seconds, older data is refreshed in the background
+
+namespace youtube_parser {
+static Mutex visitor_data_lock;
+static bool visitor_data_loaded = false;
+static std::string visitor_data;
+static time_t visitor_data_time = 0; // when `visitor_data` was fetched
+
+static std::string fetch_visitor_data() {
+	std::string url = "https://www.youtube.com/sw.js_data";
+	std::map<std::string, std::string> headers = {{"Origin", "https://www.youtube.com"},
+	                                              {"Referer", "https://www.youtube.com/"}};
+	auto response = http_get(url, headers);
+
+	if (response.first) {
+		std::string json_content = response.second;
+		const std::string unwanted_prefix = ")]}'\n";
+		if (json_content.find(unwanted_prefix) == 0) {
+			json_content = json_content.substr(unwanted_prefix.size());
+		}
+
+		rapidjson::Document document;
+		std::string error;
+		RJson data = RJson::parse(document, json_content.c_str(), error);
+
+		if (data.is_valid()) {
+			std::string res = data[static_cast<size_t>(0)][static_cast<size_t>(2)][static_cast<size_t>(0)]
+			                      [static_cast<size_t>(0)][static_cast<size_t>(13)]
+			                          .string_value();
+			logger.info("Visitor Data", "Fetched new visitor data: " + res);
+			return res;
+		} else {
+			logger.error("Visitor Data", "JSON Parsing Error: " + error);
+			return "";
+		}
+	} else {
+		logger.error("Visitor Data", "Failed to fetch visitor data");
+		return "";
+	}
+}
+
+// the following functions must be called with visitor_data_lock locked
+// file format : "<fetched time>\n<visitor data>\n"
+static void load_visitor_data() {
+	visitor_data_loaded = true;
+	std::string data;
+	if (Path(VISITOR_DATA_PATH).read_entire_file(data).code != 0) {
+		return;
+	}
+	size_t newline = data.find('\n');
+	if (newline == std::string::npos || data.size() < newline + 2 || data.back() != '\n') {
+		return;
+	}
+	visitor_data_time = strtoll(data.c_str(), NULL, 10);
+	visitor_data = data.substr(newline + 1, data.size() - newline - 2);
+}
+static void save_visitor_data() {
+	std::string data = std::to_string((long long)visitor_data_time) + "\n" + visitor_data + "\n";
+	Result_with_string result = Path(VISITOR_DATA_PATH).write_file((const u8 *)data.data(), data.size());
+	if (result.code != 0) {
+		logger.error("Visitor Data", "save failed : " + result.string + " " + std::to_string(result.code));
+	}
+}
+static bool is_visitor_data_valid(time_t now) {
+	return visitor_data != "" && visitor_data_time <= now && now - visitor_data_time < VISITOR_DATA_TTL;
+}
+
+// the network access is done without the lock so that get_visitor_data() never waits for a background refresh
+std::string refresh_visitor_data() {
+	std::string new_visitor_data = fetch_visitor_data();
+	visitor_data_lock.lock();
+	if (new_visitor_data != "") {
+		visitor_data = new_visitor_data;
+		visitor_data_time = time(NULL);
+		save_visitor_data();
+	}
+	std::string res = visitor_data;
+	visitor_data_lock.unlock();
+	return res;
+}
+static void visitor_data_refresh_task(void *) { refresh_visitor_data(); }
+
+std::string get_visitor_data(bool *cached) {
+	time_t now = time(NULL);
+	visitor_data_lock.lock();
+	if (!visitor_data_loaded) {
+		load_visitor_data();
+	}
+	bool valid = is_visitor_data_valid(now);
+	bool refresh_in_background = valid && now - visitor_data_time >= VISITOR_DATA_REFRESH_AGE;
+	std::string res = visitor_data;
+	visitor_data_lock.unlock();
+
+	if (cached) {
+		*cached = valid;
+	}
+	if (!valid) {
+		return refresh_visitor_data();
+	}
+	if (refresh_in_background && !is_async_task_running(visitor_data_refresh_task)) {
+		queue_async_task(visitor_data_refresh_task, NULL);
+	}
+	return res;
+}
+} // namespace youtube_parser
@@ -0,0 +1,275 @@
+#include "headers.hpp"
+#include "stb_image/stb_image.h"
+#include "test.hpp"
+#include <functional>
+
+// Image_decode_to_texture() against the pipeline it replaced : Image_decode() to a BGR565 buffer, the crop and the
+// rounding applied to that buffer by thumbnail_loader.cpp, then Draw_set_texture_data()
+// the old code is kept below as it was, except that memcpy_asm_4b() is a memcpy()
+//
+// the textures must match texel by texel with one known exception : Draw_set_texture_data() copies the pixels in pairs,
+// so for an odd width it also wrote the texel right after each row (x == width), outside of the subtexture, with the
+// first pixel of the next row of the image. Image_decode_to_texture() leaves that texel untouched. It's never drawn.
+
+enum class Kind { PLAIN, VIDEO_THUMBNAIL, ICON };
+
+namespace old_pipeline {
+// returns in BGR565 format, should be freed
+u8 *Image_decode(u8 *input, size_t input_len, int *width, int *height) {
+	int image_ch = 0;
+	u8 *rgb_image = stbi_load_from_memory(input, input_len, width, height, &image_ch, STBI_rgb);
+	if (!rgb_image) {
+		return NULL;
+	}
+	// + 2 : Draw_set_texture_data() reads one pixel past the end of the image when the width is odd
+	u8 *bgr_image = (u8 *)calloc(*width * *height * 2 + 2, 1);
+	if (!bgr_image) {
+		stbi_image_free(rgb_image);
+		return NULL;
+	}
+	int in_size = *width * *height * 3;
+	u16 *out_head = (u16 *)bgr_image;
+	for (int i = 0; i < in_size; i += 3) {
+		u16 r = rgb_image[i + 0];
+		u16 g = rgb_image[i + 1];
+		u16 b = rgb_image[i + 2];
+		*out_head++ = ((r & 0b11111000) << 8) | ((g & 0b11111100) << 3) | (b >> 3);
+	}
+
+	stbi_image_free(rgb_image);
+	return bgr_image;
+}
+
+int Draw_convert_to_pos(int height, int width, int img_height, int img_width, int pixel_size) {
+	int pos = img_width * height;
+	if (pos == 0) {
+		pos = img_width;
+	}
+
+	pos -= (img_width - width) - img_width;
+	return pos * pixel_size;
+}
+
+// the GPU_RGB565 path of Draw_set_texture_data()
+void Draw_set_texture_data(Image_data *c2d_image, u8 *buf, int pic_width, int pic_height, int tex_size_x,
+                           int tex_size_y) {
+	int increase_list_x[tex_size_x + 8];
+	int increase_list_y[tex_size_y + 8];
+	int count[2] = {0, 0};
+	int c3d_pos = 0;
+	int c3d_offset = 0;
+	int pixel_size = 2;
+
+	for (int i = 0; i <= tex_size_x; i += 4) {
+		increase_list_x[i] = 4 * pixel_size;
+		increase_list_x[i + 1] = 12 * pixel_size;
+		increase_list_x[i + 2] = 4 * pixel_size;
+		increase_list_x[i + 3] = 44 * pixel_size;
+	}
+	for (int i = 0; i <= tex_size_y; i += 8) {
+		increase_list_y[i] = 2 * pixel_size;
+		increase_list_y[i + 1] = 6 * pixel_size;
+		increase_list_y[i + 2] = 2 * pixel_size;
+		increase_list_y[i + 3] = 22 * pixel_size;
+		increase_list_y[i + 4] = 2 * pixel_size;
+		increase_list_y[i + 5] = 6 * pixel_size;
+		increase_list_y[i + 6] = 2 * pixel_size;
+		increase_list_y[i + 7] = (tex_size_x * 8 - 42) * pixel_size;
+	}
+	int y_max = std::min(pic_height, tex_size_y);
+	int x_max = std::min(pic_width, tex_size_x);
+
+	Draw_c2d_image_set_subtex(c2d_image, x_max, y_max);
+	for (int k = 0; k < y_max; k++) {
+		for (int i = 0; i < x_max; i += 2) {
+			memcpy(&(((u8 *)c2d_image->c2d.tex->data)[c3d_pos + c3d_offset]),
+			       &(((u8 *)buf)[Draw_convert_to_pos(k, i, pic_height, pic_width, pixel_size)]), 4);
+			c3d_pos += increase_list_x[count[0]];
+			count[0]++;
+		}
+		count[0] = 0;
+		c3d_pos = 0;
+		c3d_offset += increase_list_y[count[1]];
+		count[1]++;
+	}
+}
+
+// the decoding part of thumbnail_downloader_thread_func() in thumbnail_loader.cpp
+bool load(std::vector<u8> &data, Kind kind, Image_data *result_image, int *width, int *height) {
+	int w, h;
+	u8 *decoded_data = Image_decode(&data[0], data.size(), &w, &h);
+	if (!decoded_data) {
+		return false;
+	}
+	// some special operations on the picture here (it shouldn't be here but...)
+	// for video thumbnail, crop to 16:9
+	if (kind == Kind::VIDEO_THUMBNAIL && h > w * 9 / 16 + 1) {
+		int new_h = w * 9 / 16;
+		int vertical_offset = (h - new_h) / 2;
+		memmove(decoded_data, decoded_data + vertical_offset * w * 2, new_h * w * 2);
+		h = new_h;
+	}
+	// channel icon : round (definitely not the recommended way but we will fill the area outside the circle
+	// with white)
+	if (kind == Kind::ICON) {
+		float radius = (float)h / 2;
+		for (int i = 0; i < h; i++) {
+			for (int j = 0; j < w; j++) {
+				float distance = std::hypot(radius - (i + 0.5), radius - (j + 0.5));
+				u8 b = decoded_data[(i * w + j) * 2 + 0] & ((1 << 5) - 1);
+				u8 g = (decoded_data[(i * w + j) * 2 + 0] >> 5) |
+				       ((decoded_data[(i * w + j) * 2 + 1] & ((1 << 3) - 1)) << 3);
+				u8 r = decoded_data[(i * w + j) * 2 + 1] >> 3;
+				float proportion = std::max(0.0f, std::min(1.0f, radius + 0.5f - distance));
+				b = b * proportion + (var_night_mode ? 0 : ((1 << 5) - 1)) * (1 - proportion);
+				g = g * proportion + (var_night_mode ? 0 : ((1 << 6) - 1)) * (1 - proportion);
+				r = r * proportion + (var_night_mode ? 0 : ((1 << 5) - 1)) * (1 - proportion);
+				decoded_data[(i * w + j) * 2 + 0] = b | g << 5;
+				decoded_data[(i * w + j) * 2 + 1] = g >> 3 | r << 3;
+			}
+		}
+	}
+
+	int texture_w = 1;
+	while (texture_w < w) {
+		texture_w <<= 1;
+	}
+	int texture_h = 1;
+	while (texture_h < h) {
+		texture_h <<= 1;
+	}
+	Draw_c2d_image_init(result_image, texture_w, texture_h, GPU_RGB565);
+	Draw_set_texture_data(result_image, decoded_data, w, h, texture_w, texture_h);
+	free(decoded_data);
+	*width = w;
+	*height = h;
+	return true;
+}
+} // namespace old_pipeline
+
+// the callbacks load_thumbnail() in thumbnail_loader.cpp passes to Image_decode_to_texture()
+static bool load_new(std::vector<u8> &data, Kind kind, Image_data *result_image, int *width, int *height) {
+	float radius = 0;
+	auto crop = [&](int w, int h, int &top, int &new_h) {
+		if (kind == Kind::VIDEO_THUMBNAIL && h > w * 9 / 16 + 1) {
+			new_h = w * 9 / 16;
+			top = (h - new_h) / 2;
+		}
+		radius = (float)new_h / 2;
+	};
+	auto round = [&](u16 pixel, int x, int y) -> u16 {
+		float distance = std::hypot(radius - (y + 0.5), radius - (x + 0.5));
+		u8 b = pixel & ((1 << 5) - 1);
+		u8 g = (pixel >> 5) & ((1 << 6) - 1);
+		u8 r = pixel >> 11;
+		float proportion = std::max(0.0f, std::min(1.0f, radius + 0.5f - distance));
+		b = b * proportion + (var_night_mode ? 0 : ((1 << 5) - 1)) * (1 - proportion);
+		g = g * proportion + (var_night_mode ? 0 : ((1 << 6) - 1)) * (1 - proportion);
+		r = r * proportion + (var_night_mode ? 0 : ((1 << 5) - 1)) * (1 - proportion);
+		return b | g << 5 | r << 11;
+	};
+	Result_with_string result =
+	    Image_decode_to_texture(&data[0], data.size(), result_image, width, height, crop,
+	                            kind == Kind::ICON ? std::function<u16(u16, int, int)>(round) : nullptr);
+	return result.code == 0;
+}
+
+static u32 get_tiled_offset(int x, int y, int tex_width) {
+	u32 z_order = (x & 1) | (y & 1) << 1 | (x & 2) << 1 | (y & 2) << 2 | (x & 4) << 2 | (y & 4) << 3;
+	return (y >> 3) * tex_width * 8 + (x >> 3) * 64 + z_order;
+}
+
+static void check_same_texture(const std::string &name, std::vector<u8> data, Kind kind) {
+	Image_data old_image, new_image;
+	int old_w = 0, old_h = 0, new_w = 0, new_h = 0;
+	bool old_ok = old_pipeline::load(data, kind, &old_image, &old_w, &old_h);
+	bool new_ok = load_new(data, kind, &new_image, &new_w, &new_h);
+	CHECK(old_ok && new_ok);
+	if (!old_ok || !new_ok) {
+		return;
+	}
+	CHECK_EQ(new_w, old_w);
+	CHECK_EQ(new_h, old_h);
+	CHECK_EQ(new_image.c2d.tex->width, old_image.c2d.tex->width);
+	CHECK_EQ(new_image.c2d.tex->height, old_image.c2d.tex->height);
+	CHECK_EQ(new_image.subtex->width, old_image.subtex->width);
+	CHECK_EQ(new_image.subtex->height, old_image.subtex->height);
+	CHECK_EQ(new_image.subtex->right, old_image.subtex->right);
+	CHECK_EQ(new_image.subtex->bottom, old_image.subtex->bottom);
+
+	int tex_w = old_image.c2d.tex->width;
+	int tex_h = old_image.c2d.tex->height;
+	const u16 *old_texels = (const u16 *)old_image.c2d.tex->data;
+	const u16 *new_texels = (const u16 *)new_image.c2d.tex->data;
+	int mismatch_num = 0;
+	int odd_width_texel_num = 0;
+	for (int y = 0; y < tex_h; y++) {
+		for (int x = 0; x < tex_w; x++) {
+			u32 offset = get_tiled_offset(x, y, tex_w);
+			if (old_w % 2 && x == old_w && y < old_h) {
+				// the known difference : written by the old path only
+				CHECK_EQ(new_texels[offset], (u16)0);
+				odd_width_texel_num++;
+			} else if (old_texels[offset] != new_texels[offset]) {
+				mismatch_num++;
+			}
+		}
+	}
+	if (mismatch_num) {
+		fprintf(stderr, "%s : %d texels differ\n", name.c_str(), mismatch_num);
+	}
+	CHECK_EQ(mismatch_num, 0);
+	CHECK_EQ(odd_width_texel_num, old_w % 2 ? old_h : 0);
+
+	Draw_c2d_image_free(old_image);
+	Draw_c2d_image_free(new_image);
+}
+
+// a binary PPM (which stb_image also reads) with deterministic noise : covers the sizes the sample JPEG doesn't have
+static std::vector<u8> make_ppm(int w, int h, u32 seed) {
+	std::string header = "P6\n" + std::to_string(w) + " " + std::to_string(h) + "\n255\n";
+	std::vector<u8> res(header.begin(), header.end());
+	u32 state = seed;
+	for (int i = 0; i < w * h * 3; i++) {
+		state = state * 1103515245 + 12345;
+		res.push_back(state >> 16);
+	}
+	return res;
+}
+
+static std::vector<u8> read_file(const std::string &path) {
+	std::vector<u8> res;
+	FILE *file = fopen(path.c_str(), "rb");
+	if (!file) {
+		return res;
+	}
+	u8 buf[0x1000];
+	size_t read_size;
+	while ((read_size = fread(buf, 1, sizeof(buf), file)) > 0) {
+		res.insert(res.end(), buf, buf + read_size);
+	}
+	fclose(file);
+	return res;
+}
+
+int main() {
+	std::vector<u8> jpeg = read_file(std::string(TEST_ROOT_DIR) + "/images/0.jpg"); // 800x960
+	CHECK(jpeg.size());
+	if (jpeg.size()) {
+		check_same_texture("0.jpg plain", jpeg, Kind::PLAIN);
+		check_same_texture("0.jpg video thumbnail", jpeg, Kind::VIDEO_THUMBNAIL);
+		check_same_texture("0.jpg icon", jpeg, Kind::ICON);
+		var_night_mode = true;
+		check_same_texture("0.jpg icon (night)", jpeg, Kind::ICON);
+		var_night_mode = false;
+	}
+
+	check_same_texture("480x360 video thumbnail", make_ppm(480, 360, 1), Kind::VIDEO_THUMBNAIL);
+	check_same_texture("33x20 plain (odd width)", make_ppm(33, 20, 2), Kind::PLAIN);
+	check_same_texture("33x41 video thumbnail (odd width)", make_ppm(33, 41, 3), Kind::VIDEO_THUMBNAIL);
+	check_same_texture("45x45 icon (odd width)", make_ppm(45, 45, 4), Kind::ICON);
+	check_same_texture("88x88 icon", make_ppm(88, 88, 5), Kind::ICON);
+	check_same_texture("9x9 plain", make_ppm(9, 9, 6), Kind::PLAIN);
+
+	return test_result("image_test");
+}
@@ -0,0 +1,132 @@
+#include "youtube_parser/internal_common.hpp"
+#include "test.hpp"
+
+// JsonFilter and the SAX handler of parse_json_filtered_inplace() : the skipped members must not show up in the
+// Document and the member counts of their objects must stay right
+
+using namespace youtube_parser;
+
+static const JsonFilter filter({"videoRenderer", "shelfRenderer"});
+
+static bool is_skipped(const char *key) { return filter.is_skipped(key, strlen(key)); }
+
+static void test_is_skipped() {
+	// the unread keys, whatever their place in the sorted list
+	CHECK(is_skipped("adPlacements"));
+	CHECK(is_skipped("microformat"));
+	CHECK(is_skipped("trackingParams"));
+	CHECK(!is_skipped("contents"));
+	CHECK(!is_skipped("adSlot"));
+	CHECK(!is_skipped("trackingParamsX"));
+	CHECK(!is_skipped(""));
+	// keys are not null-terminated in the parsed string
+	CHECK(filter.is_skipped("trackingParams\":\"", 14));
+	CHECK(!filter.is_skipped("trackingParams\":\"", 13));
+
+	// the renderers are kept only if declared
+	CHECK(!is_skipped("videoRenderer"));
+	CHECK(!is_skipped("shelfRenderer"));
+	CHECK(is_skipped("adSlotRenderer"));
+	CHECK(is_skipped("lockupViewModel"));
+	CHECK(!filter.is_skipped("videoRenderer\"", 13));
+	CHECK(!is_skipped("Rendererish"));
+}
+
+static const char *INPUT = R"({
+	"trackingParams": "CAAQ",
+	"contents": [
+		{"videoRenderer": {"videoId": "abc", "lengthSeconds": 42, "badges": [{"trackingParams": "x"}]}},
+		{"adSlotRenderer": {"slots": [{"a": {"b": [1, 2, {"c": null}]}}], "text": "}]\"{["}},
+		{"shelfRenderer": {"title": "t", "lockupViewModel": {"x": 1}}, "microformat": [true, false]},
+		[]
+	],
+	"microformat": {"playerMicroformatRenderer": {}},
+	"n": -1.5
+})";
+
+static std::string parse_filtered(std::string json, Document &json_root) {
+	std::string error;
+	parse_json_filtered_inplace(json_root, &json[0], filter, error);
+	CHECK_EQ(error, std::string(""));
+	return RJson(json_root).dump();
+}
+
+static void test_filtered_parse() {
+	Document json_root;
+	std::string res = parse_filtered(INPUT, json_root);
+#ifdef YT_PARSER_FILTER_DEBUG
+	// the skipped renderers are listed with YT_PARSER_FILTER_DEBUG
+	const char *expected =
+	    R"x({"contents":[{"videoRenderer":{"videoId":"abc","lengthSeconds":42,"badges":[{}]}},)x"
+	    R"x({"(skipped renderers)":["adSlotRenderer"]},)x"
+	    R"x({"shelfRenderer":{"title":"t","(skipped renderers)":["lockupViewModel"]}},[]],"n":-1.5})x";
+	SizeType skipped_object_member_num = 1;
+#else
+	const char *expected =
+	    R"({"contents":[{"videoRenderer":{"videoId":"abc","lengthSeconds":42,"badges":[{}]}},{},)"
+	    R"({"shelfRenderer":{"title":"t"}},[]],"n":-1.5})";
+	SizeType skipped_object_member_num = 0;
+#endif
+	CHECK_EQ(res, std::string(expected));
+	CHECK_EQ(json_root["contents"][1u].MemberCount(), skipped_object_member_num);
+	CHECK_EQ(json_root.MemberCount(), (SizeType)2);
+	CHECK_EQ(json_root["contents"].Size(), (SizeType)4);
+	CHECK_EQ(json_root["contents"][0u]["videoRenderer"].MemberCount(), (SizeType)3);
+	CHECK_EQ(json_root["contents"][2u].MemberCount(), (SizeType)1);
+
+	// with nothing to skip, the same as a plain parse
+	const char *plain = R"({"a":[1,{"b":"c","d":[]},null],"e":{"videoRenderer":{"f":true}}})";
+	Document plain_root;
+	CHECK_EQ(parse_filtered(plain, plain_root), std::string(plain));
+
+	// errors, including inside a skipped subtree
+	for (std::string broken : {"{\"a\": [1, 2}", "{\"trackingParams\": {\"a\": }}", "{\"a\": 1} x"}) {
+		std::string error;
+		Document broken_root;
+		RJson data = parse_json_filtered_inplace(broken_root, &broken[0], filter, error);
+		CHECK(error != "");
+		CHECK(!data.is_valid());
+	}
+}
+
+#ifdef YT_PARSER_FILTER_DEBUG
+static int count_logs(const std::string &pattern) {
+	int res = 0;
+	for (auto &line : test_logs) {
+		res += line.find(pattern) != std::string::npos;
+	}
+	return res;
+}
+static void test_skipped_renderer_warning() {
+	std::string json = INPUT;
+	Document json_root;
+	std::string error;
+	RJson data = parse_json_filtered_inplace(json_root, &json[0], filter, error);
+	RJsonArray contents = data["contents"].array_items();
+	test_logs.clear();
+
+	// reading a renderer that is kept, or that isn't there at all, is fine
+	CHECK(contents[0]["videoRenderer"].is_valid());
+	CHECK(!contents[0]["richItemRenderer"].is_valid());
+	CHECK(!contents[1]["videoRenderer"].is_valid());
+	CHECK(!data["nonRendererKey"].is_valid());
+	CHECK_EQ(test_logs.size(), (size_t)0);
+
+	// reading a skipped one is reported, once per key
+	CHECK(!contents[1]["adSlotRenderer"].is_valid());
+	CHECK(!contents[1].has_key("adSlotRenderer"));
+	CHECK(!contents[2]["shelfRenderer"]["lockupViewModel"].is_valid());
+	CHECK_EQ(count_logs("adSlotRenderer was skipped by a json filter"), 1);
+	CHECK_EQ(count_logs("lockupViewModel was skipped by a json filter"), 1);
+	CHECK_EQ(test_logs.size(), (size_t)2);
+}
+#endif
+
+int main() {
+	test_is_skipped();
+	test_filtered_parse();
+#ifdef YT_PARSER_FILTER_DEBUG
+	test_skipped_renderer_warning();
+#endif
+	return test_result("json_filter_test");
+}
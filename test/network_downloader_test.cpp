@@ -0,0 +1,226 @@
+#include "headers.hpp"
+#include "network_decoder/network_downloader.hpp"
+#include "test.hpp"
+
+// the block arena of NetworkStream : the protocol used by the concurrent range requests (acquire a slot, write into
+// it without the lock, then commit or release it)
+
+static constexpr u64 BLOCK_SIZE = NetworkStream::BLOCK_SIZE;
+
+static NetworkStream *new_stream(u64 block_num) {
+	NetworkStream *stream = new NetworkStream("http://localhost/", block_num * BLOCK_SIZE, false, NULL);
+	stream->ready = true;
+	return stream;
+}
+static bool has_pattern(NetworkStream *stream, u64 block, u8 value) {
+	std::vector<u8> buf(BLOCK_SIZE);
+	stream->read_data(block * BLOCK_SIZE, BLOCK_SIZE, buf.data());
+	return buf.front() == value && buf.back() == value;
+}
+
+static void test_acquire_commit_release() {
+	NetworkStream *stream = new_stream(8);
+
+	// the slots reserved for a range are distinct and the blocks stay invisible until committed
+	u8 *buffers[3];
+	for (int i = 0; i < 3; i++) {
+		buffers[i] = stream->acquire_block_buffer(2 + i);
+		CHECK(buffers[i]);
+		memset(buffers[i], 0x10 + i, BLOCK_SIZE);
+	}
+	CHECK(buffers[0] != buffers[1] && buffers[1] != buffers[2] && buffers[0] != buffers[2]);
+	CHECK(!stream->is_block_available(2));
+	CHECK(!stream->is_data_available(2 * BLOCK_SIZE, 1));
+
+	stream->commit_block(2);
+	stream->commit_block(3);
+	CHECK(stream->is_block_available(2));
+	CHECK(stream->is_data_available(2 * BLOCK_SIZE, 2 * BLOCK_SIZE));
+	CHECK(!stream->is_data_available(2 * BLOCK_SIZE, 3 * BLOCK_SIZE));
+	CHECK(has_pattern(stream, 2, 0x10));
+	CHECK(has_pattern(stream, 3, 0x11));
+
+	// a failed download gives the slot back without publishing anything
+	stream->release_block_buffer(4);
+	CHECK(!stream->is_block_available(4));
+	size_t free_slot_num = stream->free_slots.size();
+	CHECK_EQ(free_slot_num, stream->slot_num - 2);
+
+	// a read spanning two blocks
+	std::vector<u8> buf(BLOCK_SIZE);
+	stream->read_data(3 * BLOCK_SIZE - 16, 32, buf.data());
+	CHECK(buf[0] == 0x10 && buf[15] == 0x10 && buf[16] == 0x11 && buf[31] == 0x11);
+
+	// re-downloading a block hides it until it's committed again, in the same slot
+	u8 *again = stream->acquire_block_buffer(2);
+	CHECK(again == buffers[0]);
+	CHECK(!stream->is_block_available(2));
+	memset(again, 0x20, BLOCK_SIZE);
+	stream->commit_block(2);
+	CHECK(has_pattern(stream, 2, 0x20));
+
+	// out of the stream
+	CHECK(!stream->acquire_block_buffer(8));
+	delete stream;
+}
+
+static void test_arena_size() {
+	// a short stream gets one slot per block
+	NetworkStream *stream = new_stream(5);
+	CHECK(stream->acquire_block_buffer(0));
+	CHECK_EQ(stream->slot_num, (size_t)5);
+	delete stream;
+
+	// a long one is capped by the cache size of the model
+	for (bool new3ds : {false, true}) {
+		var_is_new3ds = new3ds;
+		stream = new_stream(1000);
+		CHECK(stream->acquire_block_buffer(0));
+		CHECK_EQ((u64)stream->slot_num,
+		         new3ds ? NetworkStream::NEW3DS_MAX_CACHE_BLOCKS : NetworkStream::OLD3DS_MAX_CACHE_BLOCKS);
+		delete stream;
+	}
+	var_is_new3ds = true;
+}
+
+static void test_in_flight_slots_are_not_evicted() {
+	var_is_new3ds = false;
+	NetworkStream *stream = new_stream(1000);
+	size_t slot_num = 0;
+	for (u64 block = 0;; block++) {
+		u8 *buffer = stream->acquire_block_buffer(block);
+		if (!buffer) {
+			// every slot is being written into : nothing can be evicted
+			slot_num = block;
+			break;
+		}
+	}
+	CHECK_EQ(slot_num, stream->slot_num);
+	CHECK_EQ(stream->cache_stats.evicted_num, (u64)0);
+
+	// once one is committed, it can be recycled
+	stream->commit_block(0);
+	CHECK(stream->acquire_block_buffer(slot_num));
+	CHECK(!stream->is_block_available(0));
+	CHECK_EQ(stream->cache_stats.evicted_num, (u64)1);
+	delete stream;
+	var_is_new3ds = true;
+}
+
+// SeekAwareEvictionPolicy : the farthest block goes first, the distance ahead of the read head counting for less than
+// the distance behind it (the forward buffer is 80 % of the 61 slots of an old 3DS), and the protected blocks last
+static NetworkStream *new_full_stream() {
+	var_is_new3ds = false;
+	NetworkStream *stream = new_stream(1000);
+	for (u64 block = 0; block < NetworkStream::OLD3DS_MAX_CACHE_BLOCKS; block++) {
+		memset(stream->acquire_block_buffer(block), (u8)block, BLOCK_SIZE);
+		stream->commit_block(block);
+	}
+	var_is_new3ds = true;
+	return stream;
+}
+// downloads one more block with the read head at `read_head_block` and returns the block that made room for it
+static s64 evicted_block(NetworkStream *stream, u64 read_head_block) {
+	stream->set_read_head(read_head_block * BLOCK_SIZE);
+	std::vector<bool> available(stream->block_num);
+	for (u64 block = 0; block < stream->block_num; block++) {
+		available[block] = stream->is_block_available(block);
+	}
+	u64 new_block = stream->block_num - 1;
+	if (!stream->acquire_block_buffer(new_block)) {
+		return -1;
+	}
+	stream->commit_block(new_block);
+	for (u64 block = 0; block < stream->block_num; block++) {
+		if (available[block] && !stream->is_block_available(block)) {
+			return block;
+		}
+	}
+	return -1;
+}
+static void test_eviction_policy() {
+	const s64 last = NetworkStream::OLD3DS_MAX_CACHE_BLOCKS - 1; // 60
+
+	// everything is ahead of the read head : the farthest block
+	NetworkStream *stream = new_full_stream();
+	CHECK_EQ(evicted_block(stream, 0), last);
+	delete stream;
+
+	// everything is behind
+	stream = new_full_stream();
+	CHECK_EQ(evicted_block(stream, last), (s64)0);
+	delete stream;
+
+	// block 0 is 20 blocks behind (20 / 12.2) and block 60 is 40 blocks ahead (40 / 48.8) : the one behind goes
+	// although it's closer
+	stream = new_full_stream();
+	CHECK_EQ(evicted_block(stream, 20), (s64)0);
+	delete stream;
+
+	// the blocks read with protect_reads (the container header) are skipped
+	stream = new_full_stream();
+	u8 header[2];
+	stream->protect_reads = true;
+	stream->read_data(0, 1, header);
+	stream->read_data(BLOCK_SIZE, 1, header + 1);
+	stream->protect_reads = false;
+	CHECK(header[0] == 0 && header[1] == 1);
+	CHECK_EQ(evicted_block(stream, 20), (s64)2);
+	CHECK(stream->is_block_available(0) && stream->is_block_available(1));
+	delete stream;
+
+	// ... until nothing else can be evicted
+	var_is_new3ds = false;
+	stream = new_stream(1000);
+	memset(stream->acquire_block_buffer(0), 0, BLOCK_SIZE);
+	stream->commit_block(0);
+	stream->protect_reads = true;
+	stream->read_data(0, 1, header);
+	stream->protect_reads = false;
+	for (u64 block = 1; block <= (u64)last; block++) {
+		CHECK(stream->acquire_block_buffer(block)); // in flight, never evicted
+	}
+	CHECK_EQ(evicted_block(stream, 0), (s64)0);
+	delete stream;
+	var_is_new3ds = true;
+}
+
+// the size of the range requests : about 4 round trips worth of data, 1 to 16 blocks
+static u64 range_block_num(double bandwidth, double latency) {
+	NetworkStream *stream = new_stream(1000);
+	stream->bandwidth_estimate = bandwidth;
+	stream->latency_estimate = latency;
+	u64 res = NetworkStreamDownloader::get_range_block_num(stream);
+	delete stream;
+	return res;
+}
+static void test_range_block_num() {
+	// not measured yet
+	CHECK_EQ(range_block_num(0, 0), (u64)4);
+	CHECK_EQ(range_block_num(0, 0.5), (u64)4);
+
+	// 500 KB/s * 0.15 s * 4 = 300000 bytes, rounded up to 5 blocks
+	CHECK_EQ(range_block_num(500000, 0.15), (u64)5);
+	// exactly 2 blocks
+	CHECK_EQ(range_block_num(BLOCK_SIZE, 0.5), (u64)2);
+	CHECK_EQ(range_block_num(BLOCK_SIZE + 1, 0.5), (u64)3);
+
+	// clamped to [1, 16]
+	CHECK_EQ(range_block_num(1000, 0.1), (u64)1);
+	CHECK_EQ(range_block_num(2000000, 0.2), (u64)16);
+	CHECK_EQ(range_block_num(1e9, 1), (u64)16);
+
+	// the latency is at least 20 ms, so that a tiny (or not yet sampled) one doesn't shrink the requests to nothing
+	CHECK_EQ(range_block_num(1000000, 0), (u64)2);
+	CHECK_EQ(range_block_num(1000000, 0.001), (u64)2);
+	CHECK_EQ(range_block_num(1000000, 0.05), (u64)4);
+}
+
+int main() {
+	test_acquire_commit_release();
+	test_arena_size();
+	test_in_flight_slots_are_not_evicted();
+	test_eviction_policy();
+	test_range_block_num();
+	return test_result("network_downloader_test");
+}
@@ -0,0 +1,105 @@
+#include "rapidjson_wrapper.hpp"
+#include "test.hpp"
+
+// RJson (the lookup cache) and RJsonArray
+// source/youtube_parser/rapidjson_wrapper.hpp is a copy of the header tested here
+
+static void test_lookup() {
+	rapidjson::Document json_root;
+	std::string error;
+	RJson json = RJson::parse(json_root, R"({"a": "x", "b": 2, "c": {"d": true}, "e": null})", error);
+	CHECK_EQ(error, std::string(""));
+
+	CHECK(json.has_key("b"));
+	CHECK_EQ(json["b"].int_value(), 2);
+	CHECK_EQ(json["a"].string_value(), std::string("x"));
+	CHECK_EQ(json["b"].int_value(), 2);
+	CHECK(json.has_key(std::string("c")));
+	CHECK(json["c"]["d"].bool_value());
+	CHECK(json.has_key("e"));
+	CHECK(json["e"].is_valid());
+	CHECK(!json.has_key("f"));
+	CHECK(!json["f"].is_valid());
+	CHECK(!json["f"]["g"].is_valid());
+	// a prefix of the cached key
+	CHECK(json.has_key("c"));
+	CHECK(!json.has_key(""));
+
+	// not an object
+	CHECK(!json["a"]["a"].is_valid());
+	CHECK(!RJson().has_key("a"));
+	CHECK_EQ(RJson()["a"].int_value(), 0);
+	CHECK_EQ(RJson().dump(), std::string("(null)"));
+}
+
+static void test_lookup_after_modification() {
+	rapidjson::Document json_root;
+	std::string error;
+	RJson json = RJson::parse(json_root, R"({"a": "x", "b": "y", "c": "z"})", error);
+
+	// members added : the cached one may have moved
+	CHECK(json.has_key("b"));
+	for (int i = 0; i < 100; i++) {
+		json.set_str(json_root, ("key" + std::to_string(i)).c_str(), std::to_string(i).c_str());
+	}
+	CHECK_EQ(json["b"].string_value(), std::string("y"));
+	CHECK_EQ(json["key99"].string_value(), std::string("99"));
+	json.set_str(json_root, "b", "w");
+	CHECK_EQ(json["b"].string_value(), std::string("w"));
+
+	// a member removed : another one is moved into the cached slot
+	CHECK(json.has_key("a"));
+	json_root.RemoveMember("a");
+	CHECK(!json.has_key("a"));
+	CHECK(!json["a"].is_valid());
+	CHECK_EQ(json["key99"].string_value(), std::string("99"));
+
+	// a copy has its own cache
+	RJson copy = json;
+	CHECK(copy.has_key("c"));
+	CHECK(json.has_key("key0"));
+	CHECK_EQ(copy["c"].string_value(), std::string("z"));
+	CHECK_EQ(json["key0"].string_value(), std::string("0"));
+}
+
+static void test_array_items() {
+	rapidjson::Document json_root;
+	std::string error;
+	RJson json = RJson::parse(json_root, R"({"array": [1, 2, 3, {"a": 4}], "empty": [], "object": {"a": 1}})", error);
+
+	RJsonArray array = json["array"].array_items();
+	CHECK_EQ(array.size(), (size_t)4);
+	CHECK(!array.empty());
+	int sum = 0;
+	int num = 0;
+	for (auto item : array) {
+		sum += item.int_value();
+		num++;
+	}
+	CHECK_EQ(sum, 6);
+	CHECK_EQ(num, 4);
+	CHECK_EQ(array[3]["a"].int_value(), 4);
+	CHECK_EQ(array[0].int_value(), 1);
+	CHECK(!array[4].is_valid());
+	CHECK(!array[(size_t)-1].is_valid());
+
+	// the view doesn't copy the elements
+	array[3].set_str(json_root, "b", "c");
+	CHECK_EQ(json["array"].array_items()[3]["b"].string_value(), std::string("c"));
+
+	// not arrays
+	for (auto items : {json["empty"].array_items(), json["object"].array_items(), json["none"].array_items(),
+	                   RJson().array_items()}) {
+		CHECK(items.empty());
+		CHECK_EQ(items.size(), (size_t)0);
+		CHECK(items.begin() == items.end());
+		CHECK(!items[0].is_valid());
+	}
+}
+
+int main() {
+	test_lookup();
+	test_lookup_after_modification();
+	test_array_items();
+	return test_result("rapidjson_wrapper_test");
+}
@@ -0,0 +1,54 @@
+#include "youtube_parser/internal_common.hpp"
+#include "test.hpp"
+#include <regex>
+
+// RequestTemplate, against the std::regex_replace() chain it replaced
+
+using youtube_parser::RequestTemplate;
+
+static std::string render_with_regex(std::string text, const std::vector<std::string> &args) {
+	for (size_t i = 0; i < args.size(); i++) {
+		text = std::regex_replace(text, std::regex("%" + std::to_string(i)), args[i]);
+	}
+	return text;
+}
+
+static void test_same_as_regex_replace() {
+	const std::string text =
+	    R"({"context": {"client": {"hl": "%0", "gl": "%1", "clientName": "MWEB", "clientVersion": "2.20241202.07.00"}}, "query": "%2"})";
+	RequestTemplate request_template(text, 3);
+	for (auto args : std::vector<std::vector<std::string>>{
+	         {"en", "US", "lofi hip hop"}, {"ja", "JP", ""}, {"", "", "a\"b\\c"}, {"de", "DE", "100 % pure"}}) {
+		CHECK_EQ(request_template.render({args[0], args[1], args[2]}), render_with_regex(text, args));
+	}
+	// rendering doesn't alter the template
+	CHECK_EQ(request_template.render({"en", "US", "x"}), request_template.render({"en", "US", "x"}));
+}
+
+static void test_placeholders() {
+	// repeated, adjacent, at both ends
+	CHECK_EQ(RequestTemplate("%0%1-%0", 2).render({"a", "b"}), std::string("ab-a"));
+	CHECK_EQ(RequestTemplate("%1", 2).render({"a", "b"}), std::string("b"));
+	CHECK_EQ(RequestTemplate("", 2).render({"a", "b"}), std::string(""));
+	CHECK_EQ(RequestTemplate("no placeholder", 0).render({}), std::string("no placeholder"));
+
+	// only the digits below arg_num are placeholders, a marker without one is kept
+	CHECK_EQ(RequestTemplate("%0 %2 %a 100% %", 2).render({"x", "y"}), std::string("x %2 %a 100% %"));
+	// another marker
+	CHECK_EQ(RequestTemplate("$0 %0", 1, '$').render({"x"}), std::string("x %0"));
+	// missing arguments are rendered as empty
+	CHECK_EQ(RequestTemplate("[%0][%1]", 2).render({"x"}), std::string("[x][]"));
+}
+
+static void test_arguments_are_verbatim() {
+	// an argument is never scanned for placeholders nor for the `$` sequences of regex_replace()
+	RequestTemplate request_template(R"({"continuation": "%0", "query": "%1"})", 2);
+	CHECK_EQ(request_template.render({"%1$&", "$1 %0"}), std::string(R"({"continuation": "%1$&", "query": "$1 %0"})"));
+}
+
+int main() {
+	test_same_as_regex_replace();
+	test_placeholders();
+	test_arguments_are_verbatim();
+	return test_result("request_template_test");
+}
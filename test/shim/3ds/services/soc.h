@@ -0,0 +1,2 @@
+#pragma once
+// replaces libctru's soc.h on the host : its BSD socket declarations conflict with the ones of the host libc
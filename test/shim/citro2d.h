@@ -0,0 +1,94 @@
+#pragma once
+// host stand-in for citro2d/citro3d (which are not vendored in library/) : only the types and the calls that the
+// headers of the app reference, the calls do nothing
+#include <3ds.h>
+typedef struct {
+	void *data;
+	u16 width, height;
+	u32 param;
+	GPU_TEXCOLOR fmt;
+	u32 size;
+	u32 border;
+} C3D_Tex;
+typedef struct { u16 width, height; float left, top, right, bottom; } Tex3DS_SubTexture;
+typedef struct { C3D_Tex *tex; const Tex3DS_SubTexture *subtex; } C2D_Image;
+typedef struct C3D_RenderTarget_tag { int x; } C3D_RenderTarget;
+typedef struct C2D_Font_s *C2D_Font;
+typedef struct C2D_TextBuf_s *C2D_TextBuf;
+typedef struct C2D_SpriteSheet_s *C2D_SpriteSheet;
+typedef struct {
+	C2D_TextBuf buf;
+	size_t begin, end;
+	float width;
+	u32 lines, words;
+	C2D_Font font;
+} C2D_Text;
+typedef struct {
+	struct {
+		float x, y, w, h;
+	} pos;
+	struct {
+		float x, y;
+	} center;
+	float depth, angle;
+} C2D_DrawParams;
+typedef struct { u32 color; float blend; } C2D_Tint;
+typedef struct { C2D_Tint corners[4]; } C2D_ImageTint;
+enum {
+	C2D_AtBaseline = 1,
+	C2D_WithColor = 2,
+	C2D_AlignLeft = 0,
+	C2D_AlignRight = 4,
+	C2D_AlignCenter = 8,
+	C2D_AlignJustified = 12,
+	C2D_WordWrap = 16
+};
+enum { C3D_FRAME_SYNCDRAW = 1, C3D_CLEAR_ALL = 7 };
+#define C3D_DEFAULT_CMDBUF_SIZE 0x40000
+#define C2D_DEFAULT_MAX_OBJECTS 4096
+#define C2D_Color32(r,g,b,a) ((u32)((r)|((g)<<8)|((b)<<16)|((a)<<24)))
+#define C2D_Color32f(r,g,b,a) 0u
+#define C2D_DrawRectSolid(...) true
+#define C2D_DrawRectangle(...) true
+#define C2D_DrawCircleSolid(...) true
+#define C2D_DrawLine(...) true
+#define C2D_DrawTriangle(...) true
+#define C2D_DrawImage(...) true
+#define C2D_DrawImageAt(...) true
+#define C2D_DrawText(...) (void)0
+#define C2D_PlainImageTint(...) (void)0
+#define C2D_TargetClear(...) (void)0
+#define C2D_SceneBegin(...) (void)0
+#define C2D_Prepare(...) (void)0
+#define C2D_Flush(...) (void)0
+#define C2D_Init(...) true
+#define C2D_Fini(...) (void)0
+#define C3D_Init(...) true
+#define C3D_Fini(...) (void)0
+#define C3D_FrameBegin(...) true
+#define C3D_FrameEnd(...) (void)0
+#define C3D_GetProcessingTime(...) 0.0f
+#define C3D_GetDrawingTime(...) 0.0f
+#define C3D_TexInit(...) true
+#define C3D_TexDelete(...) (void)0
+#define C3D_TexFlush(...) (void)0
+#define C3D_TexSetFilter(...) (void)0
+#define C3D_TexSetWrap(...) (void)0
+#define C2D_CreateScreenTarget(...) ((C3D_RenderTarget *)0)
+#define C2D_FontLoadSystem(...) ((C2D_Font)0)
+#define C2D_FontFree(...) (void)0
+#define C2D_FontGlyphIndexFromCodePoint(...) 0
+#define C2D_FontCalcGlyphPos(...) (void)0
+#define C2D_FontGetInfo(...) ((CFNT_s *)0)
+#define C2D_TextBufNew(...) ((C2D_TextBuf)0)
+#define C2D_TextBufClear(...) (void)0
+#define C2D_TextBufDelete(...) (void)0
+#define C2D_TextFontParse(...) ((const char *)0)
+#define C2D_TextParse(...) ((const char *)0)
+#define C2D_TextOptimize(...) (void)0
+#define C2D_TextGetDimensions(...) (void)0
+#define C2D_SpriteSheetLoad(...) ((C2D_SpriteSheet)0)
+#define C2D_SpriteSheetFree(...) (void)0
+#define C2D_SpriteSheetCount(...) 0u
+#define C2D_SpriteSheetGetImage(...) C2D_Image()
+static inline void C2D_SetTintMode(int) {}
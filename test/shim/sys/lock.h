@@ -0,0 +1,7 @@
+#pragma once
+// host stand-in for the newlib header of devkitARM that libctru's synchronization.h includes
+typedef int _LOCK_T;
+typedef struct {
+	int a, b, c;
+} _LOCK_RECURSIVE_T;
+typedef int _COND_T;
@@ -0,0 +1,95 @@
+#include "headers.hpp"
+#include "network_decoder/network_io.hpp"
+#include "youtube_parser/parser.hpp"
+#include "test.hpp"
+#include <ctime>
+
+// host definitions of what the sources under test use from libctru, the drawing code and the rest of the app
+// the tests are single-threaded, so the locks and the events do nothing
+
+int test_failure_num = 0;
+std::vector<std::string> test_logs;
+
+// libctru
+void LightLock_Init(LightLock *lock) { *lock = 1; }
+void LightLock_Lock(LightLock *lock) {}
+void LightLock_Unlock(LightLock *lock) {}
+void LightEvent_Init(LightEvent *event, ResetType reset_type) {}
+void LightEvent_Signal(LightEvent *event) {}
+void LightEvent_Wait(LightEvent *event) {}
+int LightEvent_WaitTimeout(LightEvent *event, s64 timeout_in_ns) { return 1; } // timed out
+u64 svcGetSystemTick(void) {
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (u64)now.tv_sec * SYSCLOCK_ARM11 + (u64)now.tv_nsec * SYSCLOCK_ARM11 / 1000000000;
+}
+void threadExit(int rc) { abort(); }
+
+void my_assert(bool condition) {
+	if (!condition) {
+		abort();
+	}
+}
+
+// variables.cpp
+bool var_night_mode = false;
+bool var_is_new3ds = true;
+double var_forward_buffer_ratio = 0.8;
+int var_prefetch_window = 3;
+
+// log.cpp : the lines are kept in test_logs so that the tests can look for them
+Logger logger;
+void Logger::log(LogLevel level, const std::string &str) { test_logs.push_back(str); }
+
+// draw.cpp : textures live in the normal heap
+Result_with_string Draw_c2d_image_init(Image_data *c2d_image, int tex_size_x, int tex_size_y,
+                                       GPU_TEXCOLOR color_format) {
+	Result_with_string result;
+	int pixel_size = color_format == GPU_RGB565 ? 2 : color_format == GPU_RGB8 ? 3 : 4;
+	c2d_image->subtex = new Tex3DS_SubTexture();
+	c2d_image->c2d.tex = new C3D_Tex();
+	c2d_image->c2d.tex->data = calloc(tex_size_x * tex_size_y, pixel_size);
+	c2d_image->c2d.tex->width = tex_size_x;
+	c2d_image->c2d.tex->height = tex_size_y;
+	c2d_image->c2d.tex->fmt = color_format;
+	c2d_image->c2d.subtex = c2d_image->subtex;
+	return result;
+}
+void Draw_c2d_image_set_subtex(Image_data *c2d_image, int width, int height) {
+	c2d_image->subtex->width = (u16)width;
+	c2d_image->subtex->height = (u16)height;
+	c2d_image->subtex->left = 0.0;
+	c2d_image->subtex->top = 1.0;
+	c2d_image->subtex->right = width / (float)c2d_image->c2d.tex->width;
+	c2d_image->subtex->bottom = 1.0 - height / (float)c2d_image->c2d.tex->height;
+	c2d_image->c2d.subtex = c2d_image->subtex;
+}
+void Draw_c2d_image_free(Image_data c2d_image) {
+	if (c2d_image.c2d.tex) {
+		free(c2d_image.c2d.tex->data);
+	}
+	delete c2d_image.c2d.tex;
+	delete c2d_image.subtex;
+}
+
+// network_io.cpp : no network on the host
+void NetworkSessionList::init() {}
+NetworkResult NetworkSessionList::perform(const HttpRequest &request) {
+	NetworkResult result;
+	result.fail = true;
+	result.error = "no network in the host tests";
+	return result;
+}
+std::vector<NetworkResult> NetworkSessionList::perform(const std::vector<HttpRequest> &requests) {
+	std::vector<NetworkResult> results;
+	for (auto &request : requests) {
+		results.push_back(perform(request));
+	}
+	return results;
+}
+std::string NetworkResult::get_header(std::string key) { return ""; }
+
+// youtube_parser/utils.cpp
+std::string youtube_get_video_thumbnail_url_by_id(const std::string &id) {
+	return "https://i.ytimg.com/vi/" + id + "/default.jpg";
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// minimal assertion helpers for the host tests : a failed check prints its location and the test exits with 1 at the
+// end of main() (via test_result())
+
+extern int test_failure_num;
+// the lines passed to the logger (see stubs.cpp), cleared by the tests that look for a message
+extern std::vector<std::string> test_logs;
+
+#define CHECK(cond)                                                                                                    \
+	do {                                                                                                               \
+		if (!(cond)) {                                                                                                 \
+			fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);                                   \
+			test_failure_num++;                                                                                        \
+		}                                                                                                              \
+	} while (0)
+#define CHECK_EQ(a, b)                                                                                                 \
+	do {                                                                                                               \
+		auto check_a_ = (a);                                                                                           \
+		auto check_b_ = (b);                                                                                           \
+		if (!(check_a_ == check_b_)) {                                                                                 \
+			fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed : %s != %s\n", __FILE__, __LINE__, #a, #b,                \
+			        test_to_string(check_a_).c_str(), test_to_string(check_b_).c_str());                               \
+			test_failure_num++;                                                                                        \
+		}                                                                                                              \
+	} while (0)
+
+inline std::string test_to_string(const std::string &value) { return "\"" + value + "\""; }
+inline std::string test_to_string(const char *value) { return value ? test_to_string(std::string(value)) : "NULL"; }
+inline std::string test_to_string(bool value) { return value ? "true" : "false"; }
+template <typename T> std::string test_to_string(const T &value) { return std::to_string(value); }
+
+inline int test_result(const char *name) {
+	if (test_failure_num) {
+		fprintf(stderr, "%s : %d check(s) failed\n", name, test_failure_num);
+		return 1;
+	}
+	printf("%s : ok\n", name);
+	return 0;
+}